@@ -0,0 +1,321 @@
+/*
+ * File: compact_graph.cpp
+ * Description: Implementation of the CompactGraph class, responsible for packing the road network into contiguous adjacency arrays.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "compact_graph.h"
+#include <android/log.h>
+#include <algorithm>
+
+#define LOG_TAG "CompactGraph"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+void CompactGraph::build(const std::deque<Node>& nodes) {
+    size_t nodeCount = nodes.size();
+    size_t edgeCount = 0;
+    for (const Node& node : nodes) {
+        edgeCount += node.segments.size();
+    }
+
+    std::vector<double> lat(nodeCount);
+    std::vector<double> lon(nodeCount);
+    std::vector<uint32_t> offsets(nodeCount + 1);
+    std::vector<Edge> packedEdges;
+    packedEdges.reserve(edgeCount);
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        const Node& node = nodes[i];
+        lat[i] = node.latitude;
+        lon[i] = node.longitude;
+        offsets[i] = static_cast<uint32_t>(packedEdges.size());
+
+        for (const RoadSegment* segment : node.segments) {
+            packedEdges.push_back(Edge{
+                    segment->end->index,
+                    static_cast<float>(segment->length),
+                    static_cast<float>(segment->speedLimit),
+                    segment->type
+            });
+        }
+    }
+    offsets[nodeCount] = static_cast<uint32_t>(packedEdges.size());
+
+    nodeLat.assign(std::move(lat));
+    nodeLon.assign(std::move(lon));
+    firstEdge.assign(std::move(offsets));
+    edges.assign(std::move(packedEdges));
+    backingStorage.reset();
+    resetOverlay();
+    clearContraction();
+    buildReverseAdjacency();
+
+    LOGI("Built compact graph with %zu nodes and %zu edges", nodeCount, edges.size());
+}
+
+void CompactGraph::attach(const double* lat, const double* lon, size_t nodeCount,
+                          const uint32_t* offsets, const Edge* edgeData, size_t edgeCount,
+                          const uint32_t* chainOffsets, const Edge* chainEdgeData, size_t chainEdgeCount,
+                          const uint32_t* viaOffsets, const uint32_t* viaNodes, const float* viaDistances,
+                          size_t viaCount, const uint8_t* interior,
+                          const uint32_t* reverseOffsets, const ReverseEdge* reverseEdgeData,
+                          size_t reverseEdgeCount, std::shared_ptr<const void> storage) {
+    nodeLat.attach(lat, nodeCount);
+    nodeLon.attach(lon, nodeCount);
+    firstEdge.attach(offsets, nodeCount + 1);
+    edges.attach(edgeData, edgeCount);
+    chainFirst.attach(chainOffsets, nodeCount + 1);
+    chainEdges.attach(chainEdgeData, chainEdgeCount);
+    chainViaFirst.attach(viaOffsets, chainEdgeCount + 1);
+    chainViaNodes.attach(viaNodes, viaCount);
+    chainViaOffsets.attach(viaDistances, viaCount);
+    interiorNodes.attach(interior, nodeCount);
+    reverseFirst.attach(reverseOffsets, nodeCount + 1);
+    reverseEdges.attach(reverseEdgeData, reverseEdgeCount);
+    backingStorage = std::move(storage);
+    resetOverlay();
+
+    LOGI("Attached compact graph with %zu nodes and %zu edges", nodeCount, edgeCount);
+}
+
+uint32_t CompactGraph::appendNode(double lat, double lon) {
+    uint32_t index = getNodesCount();
+    appendedLat.push_back(lat);
+    appendedLon.push_back(lon);
+
+    if (!overlayHead.empty()) {
+        overlayHead.push_back(0);
+        overlayReverseHead.push_back(0);
+    }
+    return index;
+}
+
+void CompactGraph::appendEdge(uint32_t from, const Edge& edge) {
+    // Anything hanging off an interior node must be reachable, so the node is exposed first.
+    pin(from);
+    addOverlayEdge(from, edge, INVALID_EDGE, 0);
+}
+
+void CompactGraph::contractChains() {
+    uint32_t nodeCount = static_cast<uint32_t>(nodeLat.size());
+    uint32_t edgeCount = static_cast<uint32_t>(edges.size());
+
+    std::vector<uint32_t> edgeSources(edgeCount);
+    std::vector<uint32_t> inFirst(nodeCount + 1, 0);
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        for (uint32_t e = firstEdge[n]; e < firstEdge[n + 1]; e++) {
+            edgeSources[e] = n;
+            inFirst[edges[e].target + 1]++;
+        }
+    }
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        inFirst[n + 1] += inFirst[n];
+    }
+
+    std::vector<uint32_t> inEdges(edgeCount);
+    std::vector<uint32_t> cursor(inFirst.begin(), inFirst.end() - 1);
+    for (uint32_t e = 0; e < edgeCount; e++) {
+        inEdges[cursor[edges[e].target]++] = e;
+    }
+
+    resetOverlay();
+    std::vector<uint8_t> interior(nodeCount, 0);
+    uint32_t interiorCount = 0;
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        if (isInterior(n, inFirst, inEdges, edgeSources)) {
+            interior[n] = 1;
+            interiorCount++;
+        }
+    }
+
+    std::vector<uint32_t> chainOffsets(nodeCount + 1, 0);
+    std::vector<Edge> contracted;
+    std::vector<uint32_t> viaOffsets;
+    std::vector<uint32_t> viaNodes;
+    std::vector<float> viaDistances;
+    contracted.reserve(edgeCount - std::min(edgeCount, interiorCount));
+
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        chainOffsets[n] = static_cast<uint32_t>(contracted.size());
+        if (interior[n]) {
+            continue;
+        }
+
+        for (uint32_t e = firstEdge[n]; e < firstEdge[n + 1]; e++) {
+            const Edge& first = edges[e];
+            uint32_t previous = n;
+            uint32_t current = first.target;
+            float length = first.length;
+
+            viaOffsets.push_back(static_cast<uint32_t>(viaNodes.size()));
+
+            while (current < nodeCount && interior[current]) {
+                viaNodes.push_back(current);
+                viaDistances.push_back(length);
+
+                // A two-way interior node continues away from where we came from; a one-way one has a single exit.
+                uint32_t next = firstEdge[current];
+                if (firstEdge[current + 1] - next == 2 && edges[next].target == previous) {
+                    next++;
+                }
+
+                previous = current;
+                current = edges[next].target;
+                length += edges[next].length;
+            }
+
+            contracted.push_back(Edge{current, length, first.speedLimit, first.type});
+        }
+    }
+    chainOffsets[nodeCount] = static_cast<uint32_t>(contracted.size());
+    viaOffsets.push_back(static_cast<uint32_t>(viaNodes.size()));
+
+    interiorNodes.assign(std::move(interior));
+    chainFirst.assign(std::move(chainOffsets));
+    chainEdges.assign(std::move(contracted));
+    chainViaFirst.assign(std::move(viaOffsets));
+    chainViaNodes.assign(std::move(viaNodes));
+    chainViaOffsets.assign(std::move(viaDistances));
+    buildReverseAdjacency();
+
+    LOGI("Contracted %u degree-2 nodes: %u routing edges instead of %u",
+         interiorCount, static_cast<uint32_t>(chainEdges.size()), edgeCount);
+}
+
+bool CompactGraph::isInterior(uint32_t node, const std::vector<uint32_t>& inFirst,
+                              const std::vector<uint32_t>& inEdges,
+                              const std::vector<uint32_t>& edgeSources) const {
+    uint32_t outBegin = firstEdge[node];
+    uint32_t outCount = firstEdge[node + 1] - outBegin;
+    uint32_t inBegin = inFirst[node];
+    uint32_t inCount = inFirst[node + 1] - inBegin;
+
+    // Chains are only merged where every edge carries the same attributes, so any
+    // per-edge cost that is linear in length stays exact on the contracted edge.
+    auto sameAttributes = [](const Edge& a, const Edge& b) {
+        return a.speedLimit == b.speedLimit && a.type == b.type;
+    };
+
+    if (outCount == 1 && inCount == 1) {
+        const Edge& out = edges[outBegin];
+        const Edge& in = edges[inEdges[inBegin]];
+        uint32_t source = edgeSources[inEdges[inBegin]];
+        return out.target != node && source != node && out.target != source && sameAttributes(out, in);
+    }
+
+    if (outCount == 2 && inCount == 2) {
+        const Edge& outA = edges[outBegin];
+        const Edge& outB = edges[outBegin + 1];
+        uint32_t inA = inEdges[inBegin];
+        uint32_t inB = inEdges[inBegin + 1];
+        if (outA.target == outB.target || outA.target == node || outB.target == node) {
+            return false;
+        }
+        if (edgeSources[inA] != outA.target) {
+            std::swap(inA, inB);
+        }
+        if (edgeSources[inA] != outA.target || edgeSources[inB] != outB.target) {
+            return false;
+        }
+        // Travelling A -> node -> B and B -> node -> A must each keep the same attributes.
+        return sameAttributes(edges[inA], outB) && sameAttributes(edges[inB], outA);
+    }
+
+    return false;
+}
+
+void CompactGraph::pin(uint32_t node) {
+    if (!isContracted() || node >= nodeLat.size() || !interiorNodes[node] || !pinnedNodes.insert(node).second) {
+        return;
+    }
+
+    // Pins are rare (route endpoints), so the chains through the node are found by scanning.
+    for (uint32_t s = 0; s < chainViaNodes.size(); s++) {
+        if (chainViaNodes[s] != node) {
+            continue;
+        }
+
+        uint32_t chain = static_cast<uint32_t>(
+                std::upper_bound(chainViaFirst.begin(), chainViaFirst.end(), s) - chainViaFirst.begin() - 1);
+        uint32_t source = static_cast<uint32_t>(
+                std::upper_bound(chainFirst.begin(), chainFirst.end(), chain) - chainFirst.begin() - 1);
+        const Edge& chainEdge = chainEdges[chain];
+
+        addOverlayEdge(source, Edge{node, chainViaOffsets[s], chainEdge.speedLimit, chainEdge.type},
+                       chain, s - chainViaFirst[chain]);
+    }
+}
+
+float CompactGraph::findMaxSpeedLimit() const {
+    float maxSpeedLimit = 0.0f;
+    for (size_t e = 0; e < edges.size(); e++) {
+        maxSpeedLimit = std::max(maxSpeedLimit, edges[e].speedLimit);
+    }
+    return maxSpeedLimit;
+}
+
+void CompactGraph::buildReverseAdjacency() {
+    uint32_t nodeCount = static_cast<uint32_t>(nodeLat.size());
+
+    std::vector<uint32_t> offsets(nodeCount + 1, 0);
+    std::vector<ReverseEdge> transposed;
+
+    // Counts, prefix-sums, then scatters the edges forEachEdge visits from each junction.
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<uint32_t> cursor;
+        if (pass == 1) {
+            for (uint32_t n = 0; n < nodeCount; n++) {
+                offsets[n + 1] += offsets[n];
+            }
+            transposed.resize(offsets[nodeCount]);
+            cursor.assign(offsets.begin(), offsets.end() - 1);
+        }
+
+        for (uint32_t n = 0; n < nodeCount; n++) {
+            if (isChainInterior(n)) {
+                continue;
+            }
+            forEachEdge(n, [&](const Edge& edge, uint32_t edgeId) {
+                if (pass == 0) {
+                    offsets[edge.target + 1]++;
+                } else {
+                    transposed[cursor[edge.target]++] = ReverseEdge{n, edgeId};
+                }
+            });
+        }
+    }
+
+    reverseFirst.assign(std::move(offsets));
+    reverseEdges.assign(std::move(transposed));
+}
+
+void CompactGraph::resetOverlay() {
+    appendedLat.clear();
+    appendedLon.clear();
+    overlayHead.clear();
+    overlayReverseHead.clear();
+    overlayEdges.clear();
+    pinnedNodes.clear();
+}
+
+void CompactGraph::clearContraction() {
+    chainFirst.assign({});
+    chainEdges.assign({});
+    chainViaFirst.assign({});
+    chainViaNodes.assign({});
+    chainViaOffsets.assign({});
+    interiorNodes.assign({});
+}
+
+void CompactGraph::addOverlayEdge(uint32_t from, const Edge& edge, uint32_t viaEdge, uint32_t viaCount) {
+    if (overlayHead.empty()) {
+        overlayHead.assign(getNodesCount(), 0);
+        overlayReverseHead.assign(getNodesCount(), 0);
+    }
+
+    overlayEdges.push_back(OverlayEdge{from, edge, overlayHead[from], overlayReverseHead[edge.target],
+                                       viaEdge, viaCount});
+    overlayHead[from] = static_cast<uint32_t>(overlayEdges.size());
+    overlayReverseHead[edge.target] = static_cast<uint32_t>(overlayEdges.size());
+}
@@ -0,0 +1,216 @@
+/*
+ * File: compact_graph.h
+ * Description: Header file for the CompactGraph class, a frozen compressed-sparse-row view of the road network used for routing.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "packed_array.h"
+#include "road_graph.h"
+
+class CompactGraph {
+public:
+    static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+    static constexpr uint32_t INVALID_EDGE = UINT32_MAX;
+
+    struct Edge {
+        uint32_t target;
+        float length;
+        float speedLimit;
+        RoadType type;
+    };
+
+    struct ReverseEdge {
+        uint32_t source;
+        uint32_t edge;
+    };
+
+    CompactGraph() = default;
+
+    void build(const std::deque<Node>& nodes);
+
+    // Views a contracted graph stored elsewhere (a snapshot mapping) without copying it;
+    // `storage` keeps that memory alive.
+    void attach(const double* lat, const double* lon, size_t nodeCount,
+                const uint32_t* offsets, const Edge* edgeData, size_t edgeCount,
+                const uint32_t* chainOffsets, const Edge* chainEdgeData, size_t chainEdgeCount,
+                const uint32_t* viaOffsets, const uint32_t* viaNodes, const float* viaDistances, size_t viaCount,
+                const uint8_t* interior,
+                const uint32_t* reverseOffsets, const ReverseEdge* reverseEdgeData, size_t reverseEdgeCount,
+                std::shared_ptr<const void> storage);
+
+    uint32_t appendNode(double lat, double lon);
+    void appendEdge(uint32_t from, const Edge& edge);
+
+    // Replaces chains of degree-2 nodes with single routing edges between junctions.
+    // Interior chain nodes keep their original edges so a search can still start inside a chain.
+    void contractChains();
+    bool isContracted() const { return !chainFirst.empty(); }
+    bool isChainInterior(uint32_t node) const {
+        return isContracted() && node < nodeLat.size() && interiorNodes[node];
+    }
+
+    // Makes an interior chain node reachable by adding overlay edges from the chain's junctions.
+    void pin(uint32_t node);
+
+    uint32_t getNodesCount() const { return static_cast<uint32_t>(nodeLat.size() + appendedLat.size()); }
+    uint32_t getBaseNodesCount() const { return static_cast<uint32_t>(nodeLat.size()); }
+    size_t getEdgesCount() const { return edges.size() + overlayEdges.size(); }
+
+    // Highest speed limit of any edge, found by a scan. Chains and overlay edges only ever
+    // carry the speeds of the base edges they replace.
+    float findMaxSpeedLimit() const;
+
+    double latitude(uint32_t node) const {
+        return node < nodeLat.size() ? nodeLat[node] : appendedLat[node - nodeLat.size()];
+    }
+
+    double longitude(uint32_t node) const {
+        return node < nodeLon.size() ? nodeLon[node] : appendedLon[node - nodeLon.size()];
+    }
+
+    // Visits (edge, edgeId); edge ids are stable and can be expanded with forEachViaNode.
+    template <typename Visitor>
+    void forEachEdge(uint32_t node, Visitor&& visit) const {
+        if (node < nodeLat.size()) {
+            if (isContracted() && !interiorNodes[node]) {
+                uint32_t base = static_cast<uint32_t>(edges.size());
+                for (uint32_t c = chainFirst[node]; c < chainFirst[node + 1]; c++) {
+                    visit(chainEdges[c], base + c);
+                }
+            } else {
+                for (uint32_t e = firstEdge[node]; e < firstEdge[node + 1]; e++) {
+                    visit(edges[e], e);
+                }
+            }
+        }
+
+        if (overlayHead.empty()) {
+            return;
+        }
+
+        uint32_t base = static_cast<uint32_t>(edges.size() + chainEdges.size());
+        for (uint32_t o = overlayHead[node]; o != 0; o = overlayEdges[o - 1].next) {
+            visit(overlayEdges[o - 1].edge, base + o - 1);
+        }
+    }
+
+    // Visits the nodes an edge passes through between its source and target, in travel order.
+    template <typename Visitor>
+    void forEachViaNode(uint32_t edgeId, Visitor&& visit) const {
+        if (edgeId < edges.size()) {
+            return;
+        }
+
+        uint32_t chain = edgeId - static_cast<uint32_t>(edges.size());
+        uint32_t count;
+        if (chain < chainEdges.size()) {
+            count = chainViaFirst[chain + 1] - chainViaFirst[chain];
+        } else {
+            const OverlayEdge& overlay = overlayEdges[chain - chainEdges.size()];
+            chain = overlay.viaEdge;
+            count = overlay.viaCount;
+        }
+
+        if (chain == INVALID_EDGE) {
+            return;
+        }
+        for (uint32_t s = chainViaFirst[chain]; s < chainViaFirst[chain] + count; s++) {
+            visit(chainViaNodes[s]);
+        }
+    }
+
+    // Visits (source, edge, edgeId) for every routing edge ending at `node`. Edges leaving interior
+    // chain nodes are left out: walking backwards, the chain edge from the junction already covers them.
+    template <typename Visitor>
+    void forEachReverseEdge(uint32_t node, Visitor&& visit) const {
+        if (node < nodeLat.size()) {
+            for (uint32_t r = reverseFirst[node]; r < reverseFirst[node + 1]; r++) {
+                const ReverseEdge& reverse = reverseEdges[r];
+                visit(reverse.source, routingEdge(reverse.edge), reverse.edge);
+            }
+        }
+
+        forEachOverlayEdgeInto(node, [&](uint32_t source, const Edge& edge, uint32_t edgeId) {
+            visit(source, edge, edgeId);
+        });
+    }
+
+    // Visits (source, edge, edgeId) for every overlay edge ending at `node`.
+    template <typename Visitor>
+    void forEachOverlayEdgeInto(uint32_t node, Visitor&& visit) const {
+        if (overlayReverseHead.empty()) {
+            return;
+        }
+
+        uint32_t base = static_cast<uint32_t>(edges.size() + chainEdges.size());
+        for (uint32_t o = overlayReverseHead[node]; o != 0; o = overlayEdges[o - 1].reverseNext) {
+            const OverlayEdge& overlay = overlayEdges[o - 1];
+            visit(overlay.source, overlay.edge, base + o - 1);
+        }
+    }
+
+private:
+    friend class GraphSnapshot;
+    friend class ContractionHierarchy;
+    friend class LandmarkIndex;
+
+    struct OverlayEdge {
+        uint32_t source;
+        Edge edge;
+        uint32_t next;
+        uint32_t reverseNext;
+        uint32_t viaEdge;
+        uint32_t viaCount;
+    };
+
+    PackedArray<double> nodeLat;
+    PackedArray<double> nodeLon;
+    PackedArray<uint32_t> firstEdge;
+    PackedArray<Edge> edges;
+    std::shared_ptr<const void> backingStorage;
+
+    // Nodes and segments added after the graph is frozen (projected route endpoints)
+    // are kept beside the packed arrays instead of rebuilding them.
+    std::vector<double> appendedLat;
+    std::vector<double> appendedLon;
+    std::vector<uint32_t> overlayHead;
+    std::vector<uint32_t> overlayReverseHead;
+    std::vector<OverlayEdge> overlayEdges;
+
+    // Contracted adjacency used for junctions; via nodes and their distance from the chain start
+    // are stored per chain edge so paths can be expanded back to the full geometry.
+    PackedArray<uint32_t> chainFirst;
+    PackedArray<Edge> chainEdges;
+    PackedArray<uint32_t> chainViaFirst;
+    PackedArray<uint32_t> chainViaNodes;
+    PackedArray<float> chainViaOffsets;
+    PackedArray<uint8_t> interiorNodes;
+    std::unordered_set<uint32_t> pinnedNodes;
+
+    // Transpose of the routing edges of base nodes, rebuilt whenever the routing edges change.
+    PackedArray<uint32_t> reverseFirst;
+    PackedArray<ReverseEdge> reverseEdges;
+
+    const Edge& routingEdge(uint32_t edgeId) const {
+        if (edgeId < edges.size()) {
+            return edges[edgeId];
+        }
+        edgeId -= static_cast<uint32_t>(edges.size());
+        return edgeId < chainEdges.size() ? chainEdges[edgeId] : overlayEdges[edgeId - chainEdges.size()].edge;
+    }
+
+    void buildReverseAdjacency();
+    void resetOverlay();
+    void clearContraction();
+    void addOverlayEdge(uint32_t from, const Edge& edge, uint32_t viaEdge, uint32_t viaCount);
+    bool isInterior(uint32_t node, const std::vector<uint32_t>& inFirst,
+                    const std::vector<uint32_t>& inEdges, const std::vector<uint32_t>& edgeSources) const;
+};
@@ -0,0 +1,394 @@
+/*
+ * File: contraction_hierarchy.cpp
+ * Description: Implementation of the ContractionHierarchy class, responsible for node ordering, shortcut creation and bidirectional upward queries.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "contraction_hierarchy.h"
+#include "search_workspace.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#define LOG_TAG "ContractionHierarchy"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+constexpr float INFINITE_WEIGHT = std::numeric_limits<float>::infinity();
+
+struct BuildEdge {
+    uint32_t node;
+    float weight;
+    uint32_t middle;
+};
+
+using Entry = std::pair<float, uint32_t>;
+using MinQueue = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+
+void addOrImprove(std::vector<BuildEdge>& list, uint32_t node, float weight, uint32_t middle) {
+    for (BuildEdge& edge : list) {
+        if (edge.node == node) {
+            if (weight < edge.weight) {
+                edge.weight = weight;
+                edge.middle = middle;
+            }
+            return;
+        }
+    }
+    list.push_back({node, weight, middle});
+}
+
+void removeNode(std::vector<BuildEdge>& list, uint32_t node) {
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [node](const BuildEdge& edge) { return edge.node == node; }),
+               list.end());
+}
+
+class HierarchyBuilder {
+public:
+    explicit HierarchyBuilder(uint32_t nodeCount)
+            : out(nodeCount), in(nodeCount), contracted(nodeCount, false),
+              deletedNeighbors(nodeCount, 0), witnessDistance(nodeCount, INFINITE_WEIGHT),
+              up(nodeCount), down(nodeCount) {}
+
+    std::vector<std::vector<BuildEdge>> out;
+    std::vector<std::vector<BuildEdge>> in;
+    std::vector<bool> contracted;
+    std::vector<int> deletedNeighbors;
+    std::vector<float> witnessDistance;
+    std::vector<uint32_t> touched;
+
+    std::vector<std::vector<BuildEdge>> up;
+    std::vector<std::vector<BuildEdge>> down;
+    size_t shortcutCount = 0;
+
+    int priority(uint32_t node) {
+        int shortcuts = static_cast<int>(processNode(node, false));
+        int removed = static_cast<int>(in[node].size() + out[node].size());
+        return shortcuts - removed + deletedNeighbors[node];
+    }
+
+    void contract(uint32_t node) {
+        shortcutCount += processNode(node, true);
+
+        for (const BuildEdge& edge : out[node]) {
+            up[node].push_back(edge);
+            removeNode(in[edge.node], node);
+            deletedNeighbors[edge.node]++;
+        }
+        for (const BuildEdge& edge : in[node]) {
+            down[node].push_back(edge);
+            removeNode(out[edge.node], node);
+            deletedNeighbors[edge.node]++;
+        }
+
+        contracted[node] = true;
+        std::vector<BuildEdge>().swap(out[node]);
+        std::vector<BuildEdge>().swap(in[node]);
+    }
+
+private:
+    // Counts (and, when applying, inserts) the shortcuts needed to keep distances exact once `node` is gone.
+    size_t processNode(uint32_t node, bool apply) {
+        size_t shortcuts = 0;
+
+        for (size_t i = 0; i < in[node].size(); i++) {
+            BuildEdge incoming = in[node][i];
+            float limit = 0.0f;
+            for (const BuildEdge& outgoing : out[node]) {
+                if (outgoing.node != incoming.node) {
+                    limit = std::max(limit, incoming.weight + outgoing.weight);
+                }
+            }
+            if (limit == 0.0f) {
+                continue;
+            }
+
+            witnessSearch(incoming.node, node, limit);
+
+            for (size_t j = 0; j < out[node].size(); j++) {
+                BuildEdge outgoing = out[node][j];
+                if (outgoing.node == incoming.node) {
+                    continue;
+                }
+
+                float viaWeight = incoming.weight + outgoing.weight;
+                if (witnessDistance[outgoing.node] <= viaWeight) {
+                    continue;
+                }
+
+                shortcuts++;
+                if (apply) {
+                    addOrImprove(out[incoming.node], outgoing.node, viaWeight, node);
+                    addOrImprove(in[outgoing.node], incoming.node, viaWeight, node);
+                }
+            }
+        }
+
+        return shortcuts;
+    }
+
+    // Bounded Dijkstra from `source` that ignores `excluded` and already contracted nodes.
+    void witnessSearch(uint32_t source, uint32_t excluded, float limit) {
+        for (uint32_t node : touched) {
+            witnessDistance[node] = INFINITE_WEIGHT;
+        }
+        touched.clear();
+
+        MinQueue queue;
+        witnessDistance[source] = 0.0f;
+        touched.push_back(source);
+        queue.push({0.0f, source});
+
+        size_t settled = 0;
+        while (!queue.empty() && settled < WITNESS_SETTLE_LIMIT) {
+            Entry current = queue.top();
+            queue.pop();
+            if (current.first > witnessDistance[current.second]) {
+                continue;
+            }
+            if (current.first > limit) {
+                break;
+            }
+            settled++;
+
+            for (const BuildEdge& edge : out[current.second]) {
+                if (edge.node == excluded || contracted[edge.node]) {
+                    continue;
+                }
+                float distance = current.first + edge.weight;
+                if (distance < witnessDistance[edge.node]) {
+                    if (witnessDistance[edge.node] == INFINITE_WEIGHT) {
+                        touched.push_back(edge.node);
+                    }
+                    witnessDistance[edge.node] = distance;
+                    queue.push({distance, edge.node});
+                }
+            }
+        }
+    }
+};
+
+template <typename T>
+void flatten(const std::vector<std::vector<BuildEdge>>& lists, std::vector<uint32_t>& first,
+             std::vector<T>& edges) {
+    first.assign(lists.size() + 1, 0);
+    for (size_t i = 0; i < lists.size(); i++) {
+        first[i] = static_cast<uint32_t>(edges.size());
+        for (const BuildEdge& edge : lists[i]) {
+            edges.push_back(T{edge.node, edge.weight, edge.middle});
+        }
+    }
+    first[lists.size()] = static_cast<uint32_t>(edges.size());
+}
+
+}
+
+void ContractionHierarchy::build(const CompactGraph& graph) {
+    auto buildStart = std::chrono::steady_clock::now();
+
+    uint32_t nodeCount = static_cast<uint32_t>(graph.nodeLat.size());
+    HierarchyBuilder builder(nodeCount);
+
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        for (uint32_t e = graph.firstEdge[n]; e < graph.firstEdge[n + 1]; e++) {
+            const CompactGraph::Edge& edge = graph.edges[e];
+            if (edge.target == n) {
+                continue;
+            }
+            addOrImprove(builder.out[n], edge.target, edge.length, NO_MIDDLE);
+            addOrImprove(builder.in[edge.target], n, edge.length, NO_MIDDLE);
+        }
+    }
+
+    // Lazy updates: a node is only contracted if its refreshed priority is still the smallest.
+    std::priority_queue<std::pair<int, uint32_t>, std::vector<std::pair<int, uint32_t>>,
+            std::greater<std::pair<int, uint32_t>>> order;
+    for (uint32_t n = 0; n < nodeCount; n++) {
+        order.push({builder.priority(n), n});
+    }
+
+    while (!order.empty()) {
+        uint32_t node = order.top().second;
+        order.pop();
+        if (builder.contracted[node]) {
+            continue;
+        }
+
+        int current = builder.priority(node);
+        if (!order.empty() && current > order.top().first) {
+            order.push({current, node});
+            continue;
+        }
+
+        builder.contract(node);
+    }
+
+    std::vector<uint32_t> upOffsets;
+    std::vector<Edge> upData;
+    std::vector<uint32_t> downOffsets;
+    std::vector<Edge> downData;
+    flatten(builder.up, upOffsets, upData);
+    flatten(builder.down, downOffsets, downData);
+
+    upFirst.assign(std::move(upOffsets));
+    upEdges.assign(std::move(upData));
+    downFirst.assign(std::move(downOffsets));
+    downEdges.assign(std::move(downData));
+    backingStorage.reset();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - buildStart).count();
+    LOGI("Built contraction hierarchy over %u nodes: %zu shortcuts, %zu edges, %lld ms",
+         nodeCount, builder.shortcutCount, getEdgesCount(), static_cast<long long>(elapsed));
+}
+
+void ContractionHierarchy::attach(const uint32_t* upOffsets, const Edge* upData, size_t upCount,
+                                  const uint32_t* downOffsets, const Edge* downData, size_t downCount,
+                                  size_t nodeCount, std::shared_ptr<const void> storage) {
+    upFirst.attach(upOffsets, nodeCount + 1);
+    upEdges.attach(upData, upCount);
+    downFirst.attach(downOffsets, nodeCount + 1);
+    downEdges.attach(downData, downCount);
+    backingStorage = std::move(storage);
+
+    LOGI("Attached contraction hierarchy over %zu nodes with %zu edges", nodeCount, getEdgesCount());
+}
+
+bool ContractionHierarchy::findPath(const std::vector<Seed>& sources, const std::vector<Seed>& targets,
+                                    std::vector<uint32_t>& path, double& distance) const {
+    // Labels store the parent in Step::previous and the shortcut's middle node in Step::edge.
+    SearchWorkspace* labels[2] = {&SearchWorkspace::forThread(0), &SearchWorkspace::forThread(1)};
+    const std::vector<Seed>* seeds[2] = {&sources, &targets};
+    const PackedArray<uint32_t>* firsts[2] = {&upFirst, &downFirst};
+    const PackedArray<Edge>* lists[2] = {&upEdges, &downEdges};
+
+    size_t nodeCount = getNodesCount();
+    for (int side = 0; side < 2; side++) {
+        labels[side]->reset(nodeCount);
+        for (const Seed& seed : *seeds[side]) {
+            if (seed.node >= nodeCount) {
+                continue;
+            }
+            if (seed.distance < labels[side]->distance(seed.node)) {
+                labels[side]->setDistance(seed.node, seed.distance, {CompactGraph::INVALID_NODE, NO_MIDDLE});
+                labels[side]->queue().push(seed.node, seed.distance);
+            }
+        }
+    }
+    IndexedHeap* queues[2] = {&labels[0]->queue(), &labels[1]->queue()};
+
+    double best = std::numeric_limits<double>::infinity();
+    uint32_t meeting = CompactGraph::INVALID_NODE;
+
+    while (!queues[0]->empty() || !queues[1]->empty()) {
+        double forwardMin = queues[0]->empty() ? best : queues[0]->top().key;
+        double backwardMin = queues[1]->empty() ? best : queues[1]->top().key;
+        if (forwardMin >= best && backwardMin >= best) {
+            break;
+        }
+
+        int side = forwardMin <= backwardMin ? 0 : 1;
+        IndexedHeap::Entry current = queues[side]->pop();
+
+        uint32_t node = current.node;
+        double opposite = labels[1 - side]->distance(node);
+        if (current.key + opposite < best) {
+            best = current.key + opposite;
+            meeting = node;
+        }
+
+        const PackedArray<uint32_t>& first = *firsts[side];
+        const PackedArray<Edge>& list = *lists[side];
+        for (uint32_t e = first[node]; e < first[node + 1]; e++) {
+            const Edge& edge = list[e];
+            double candidate = current.key + edge.weight;
+            if (candidate >= best) {
+                continue;
+            }
+
+            if (candidate < labels[side]->distance(edge.target)) {
+                labels[side]->setDistance(edge.target, candidate, {node, edge.middle});
+                queues[side]->push(edge.target, candidate);
+            }
+        }
+    }
+
+    path.clear();
+    if (meeting == CompactGraph::INVALID_NODE) {
+        return false;
+    }
+    distance = best;
+
+    std::vector<uint32_t> forwardChain;
+    for (uint32_t node = meeting; node != CompactGraph::INVALID_NODE; node = labels[0]->step(node).previous) {
+        forwardChain.push_back(node);
+    }
+    std::reverse(forwardChain.begin(), forwardChain.end());
+
+    path.push_back(forwardChain.front());
+    for (size_t i = 1; i < forwardChain.size(); i++) {
+        uint32_t to = forwardChain[i];
+        unpackEdge(forwardChain[i - 1], to, labels[0]->step(to).edge, path);
+    }
+
+    for (uint32_t node = meeting; labels[1]->step(node).previous != CompactGraph::INVALID_NODE;) {
+        const SearchWorkspace::Step& step = labels[1]->step(node);
+        unpackEdge(node, step.previous, step.edge, path);
+        node = step.previous;
+    }
+
+    return true;
+}
+
+const ContractionHierarchy::Edge* ContractionHierarchy::findEdge(const PackedArray<uint32_t>& first,
+                                                                 const PackedArray<Edge>& list,
+                                                                 uint32_t node, uint32_t target) const {
+    for (uint32_t e = first[node]; e < first[node + 1]; e++) {
+        if (list[e].target == target) {
+            return &list[e];
+        }
+    }
+    return nullptr;
+}
+
+void ContractionHierarchy::unpackEdge(uint32_t from, uint32_t to, uint32_t middle,
+                                      std::vector<uint32_t>& path) const {
+    struct Pending {
+        uint32_t from;
+        uint32_t to;
+        uint32_t middle;
+    };
+
+    // Appends the original nodes after `from` up to and including `to`.
+    std::vector<Pending> stack = {{from, to, middle}};
+    while (!stack.empty()) {
+        Pending current = stack.back();
+        stack.pop_back();
+
+        if (current.middle == NO_MIDDLE) {
+            path.push_back(current.to);
+            continue;
+        }
+
+        // The bypassed node was contracted first, so both halves are stored at it.
+        uint32_t via = current.middle;
+        const Edge* firstHalf = findEdge(downFirst, downEdges, via, current.from);
+        const Edge* secondHalf = findEdge(upFirst, upEdges, via, current.to);
+        if (!firstHalf || !secondHalf) {
+            LOGD("Shortcut %u -> %u via %u could not be unpacked", current.from, current.to, via);
+            path.push_back(current.to);
+            continue;
+        }
+
+        stack.push_back({via, current.to, secondHalf->middle});
+        stack.push_back({current.from, via, firstHalf->middle});
+    }
+}
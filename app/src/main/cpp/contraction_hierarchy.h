@@ -0,0 +1,64 @@
+/*
+ * File: contraction_hierarchy.h
+ * Description: Header file for the ContractionHierarchy class, a shortest-distance hierarchy over the frozen road graph.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "compact_graph.h"
+#include "packed_array.h"
+
+class ContractionHierarchy {
+public:
+    static constexpr uint32_t NO_MIDDLE = UINT32_MAX;
+
+    // An edge towards a higher-ranked node; shortcuts remember the node they bypass.
+    struct Edge {
+        uint32_t target;
+        float weight;
+        uint32_t middle;
+    };
+
+    // A search entry point with the distance already travelled to reach it.
+    struct Seed {
+        uint32_t node;
+        double distance;
+    };
+
+    ContractionHierarchy() = default;
+
+    void build(const CompactGraph& graph);
+
+    void attach(const uint32_t* upOffsets, const Edge* upData, size_t upCount,
+                const uint32_t* downOffsets, const Edge* downData, size_t downCount,
+                size_t nodeCount, std::shared_ptr<const void> storage);
+
+    // Shortest path by length between any source seed and any target seed. The returned
+    // node indices start at the chosen source seed and end at the chosen target seed.
+    bool findPath(const std::vector<Seed>& sources, const std::vector<Seed>& targets,
+                  std::vector<uint32_t>& path, double& distance) const;
+
+    size_t getNodesCount() const { return upFirst.empty() ? 0 : upFirst.size() - 1; }
+    size_t getEdgesCount() const { return upEdges.size() + downEdges.size(); }
+
+private:
+    friend class GraphSnapshot;
+
+    // upEdges[v] leave v towards higher ranks; downEdges[v] hold edges u -> v from higher-ranked u.
+    PackedArray<uint32_t> upFirst;
+    PackedArray<Edge> upEdges;
+    PackedArray<uint32_t> downFirst;
+    PackedArray<Edge> downEdges;
+    std::shared_ptr<const void> backingStorage;
+
+    const Edge* findEdge(const PackedArray<uint32_t>& first, const PackedArray<Edge>& list,
+                         uint32_t node, uint32_t target) const;
+
+    void unpackEdge(uint32_t from, uint32_t to, uint32_t middle, std::vector<uint32_t>& path) const;
+};
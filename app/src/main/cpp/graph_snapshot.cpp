@@ -0,0 +1,570 @@
+/*
+ * File: graph_snapshot.cpp
+ * Description: Implementation of the GraphSnapshot class, responsible for writing road graph snapshots and memory-mapping them back.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "graph_snapshot.h"
+#include <android/log.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#define LOG_TAG "GraphSnapshot"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+static_assert(std::is_trivially_copyable<CompactGraph::Edge>::value, "Edge must be trivially copyable");
+static_assert(sizeof(CompactGraph::Edge) == 16, "Edge layout is part of the snapshot format");
+static_assert(sizeof(CompactGraph::ReverseEdge) == 8, "Reverse edge layout is part of the snapshot format");
+static_assert(sizeof(SegmentRTree::Box) == 32, "Box layout is part of the snapshot format");
+static_assert(sizeof(ContractionHierarchy::Edge) == 12, "Hierarchy edge layout is part of the snapshot format");
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'N', 'A', 'V', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+size_t paddedSize(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// CSR offsets must run from 0 to `total` without decreasing.
+bool validOffsets(const uint32_t* offsets, uint64_t count, uint64_t total) {
+    if (offsets[0] != 0 || offsets[count] != total) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename Index>
+bool allBelow(const T* values, uint64_t count, uint64_t limit, Index index) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (index(values[i]) >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+struct GraphSnapshot::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t sourceFingerprint;
+    uint64_t nodeCount;
+    uint64_t edgeCount;
+    uint64_t chainEdgeCount;
+    uint64_t chainViaCount;
+    uint64_t reverseEdgeCount;
+    uint64_t nameCount;
+    uint64_t treeBoxCount;
+    uint64_t treeLevelCount;
+    uint64_t treeItemCount;
+    uint64_t hierarchyNodeCount;
+    uint64_t hierarchyUpCount;
+    uint64_t hierarchyDownCount;
+    uint64_t landmarkCount;
+    uint64_t sectionOffset[SECTION_COUNT];
+    uint64_t sectionSize[SECTION_COUNT];
+};
+
+namespace {
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(FILE* file, uint64_t headerSize) : file(file), offset(headerSize) {}
+
+    void writeSection(GraphSnapshot::Section id, const void* data, size_t size,
+                      uint64_t* offsets, uint64_t* sizes) {
+        offsets[id] = offset;
+        sizes[id] = size;
+
+        size_t whole = size & ~static_cast<size_t>(7);
+        payloadChecksum = GraphSnapshot::checksum(data, whole, payloadChecksum);
+
+        uint8_t tail[8] = {0};
+        size_t tailSize = size - whole;
+        if (tailSize > 0) {
+            std::memcpy(tail, static_cast<const uint8_t*>(data) + whole, tailSize);
+            payloadChecksum = GraphSnapshot::checksum(tail, sizeof(tail), payloadChecksum);
+        }
+
+        if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+            failed = true;
+        }
+        size_t padding = paddedSize(size) - size;
+        if (padding > 0 && std::fwrite(tail + tailSize, 1, padding, file) != padding) {
+            failed = true;
+        }
+
+        offset += paddedSize(size);
+    }
+
+    template <typename T>
+    void writeSection(GraphSnapshot::Section id, const std::vector<T>& values,
+                      uint64_t* offsets, uint64_t* sizes) {
+        writeSection(id, values.data(), values.size() * sizeof(T), offsets, sizes);
+    }
+
+    FILE* file;
+    uint64_t offset;
+    uint64_t payloadChecksum = 0xcbf29ce484222325ULL;
+    bool failed = false;
+};
+
+}
+
+GraphSnapshot::~GraphSnapshot() {
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), mappingSize);
+    }
+}
+
+bool GraphSnapshot::write(const std::string& path, const RoadGraph& graph, uint64_t sourceFingerprint) {
+    const CompactGraph* compact = graph.compactGraph.get();
+    if (!compact || !compact->isContracted()) {
+        LOGE("Cannot write snapshot of a graph that has not been frozen");
+        return false;
+    }
+
+    size_t nodeCount = compact->nodeLat.size();
+    size_t edgeCount = compact->edges.size();
+
+    std::vector<int64_t> nodeIds(nodeCount);
+    std::vector<uint32_t> edgeNames(edgeCount);
+    std::vector<uint8_t> edgeFlags(edgeCount);
+    std::vector<uint32_t> edgeOfSegment(graph.segmentStorage.size() + 1, UINT32_MAX);
+
+    std::unordered_map<std::string_view, uint32_t> nameIndex;
+    std::vector<uint32_t> nameOffsets = {0};
+    std::string nameData;
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        const Node& node = graph.nodeStorage[i];
+        nodeIds[i] = node.id;
+
+        uint32_t first = compact->firstEdge[i];
+        uint32_t last = compact->firstEdge[i + 1];
+        for (uint32_t e = first; e < last; e++) {
+            const RoadSegment* segment = node.segments[e - first];
+
+            auto interned = nameIndex.find(segment->name);
+            if (interned == nameIndex.end()) {
+                interned = nameIndex.emplace(segment->name, static_cast<uint32_t>(nameIndex.size())).first;
+                nameData += segment->name;
+                nameOffsets.push_back(static_cast<uint32_t>(nameData.size()));
+            }
+
+            edgeNames[e] = interned->second;
+            edgeFlags[e] = segment->isOneway ? EDGE_FLAG_ONEWAY : 0;
+            edgeOfSegment[segment->id] = e;
+        }
+    }
+
+    std::vector<uint64_t> levelEnds;
+    std::vector<uint32_t> treeItems;
+    const SegmentRTree* tree = graph.segmentTree.get();
+    if (tree) {
+        levelEnds.assign(tree->levelEnds.begin(), tree->levelEnds.end());
+        treeItems.reserve(tree->items.size());
+        for (const RoadSegment* segment : tree->items) {
+            treeItems.push_back(edgeOfSegment[segment->id]);
+        }
+    }
+
+    std::string tempPath = path + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        LOGE("Failed to create snapshot file %s", tempPath.c_str());
+        return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.sourceFingerprint = sourceFingerprint;
+    header.nodeCount = nodeCount;
+    header.edgeCount = edgeCount;
+    header.chainEdgeCount = compact->chainEdges.size();
+    header.chainViaCount = compact->chainViaNodes.size();
+    header.reverseEdgeCount = compact->reverseEdges.size();
+    header.nameCount = nameOffsets.size() - 1;
+    header.treeBoxCount = tree ? tree->boxes.size() : 0;
+    header.treeLevelCount = levelEnds.size();
+    header.treeItemCount = treeItems.size();
+
+    // A hierarchy is only stored when it covers exactly the packed nodes.
+    const ContractionHierarchy* hierarchy = graph.hierarchy.get();
+    if (hierarchy && hierarchy->getNodesCount() != nodeCount) {
+        hierarchy = nullptr;
+    }
+    header.hierarchyNodeCount = hierarchy ? nodeCount : 0;
+    header.hierarchyUpCount = hierarchy ? hierarchy->upEdges.size() : 0;
+    header.hierarchyDownCount = hierarchy ? hierarchy->downEdges.size() : 0;
+
+    const LandmarkIndex* landmarks = graph.landmarks.get();
+    if (landmarks && landmarks->getNodesCount() != nodeCount) {
+        landmarks = nullptr;
+    }
+    header.landmarkCount = landmarks ? landmarks->getLandmarksCount() : 0;
+
+    SnapshotWriter writer(file, sizeof(header));
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        writer.failed = true;
+    }
+
+    uint64_t* offsets = header.sectionOffset;
+    uint64_t* sizes = header.sectionSize;
+    writer.writeSection(NODE_IDS, nodeIds, offsets, sizes);
+    writer.writeSection(NODE_LATITUDES, compact->nodeLat.data(), nodeCount * sizeof(double), offsets, sizes);
+    writer.writeSection(NODE_LONGITUDES, compact->nodeLon.data(), nodeCount * sizeof(double), offsets, sizes);
+    writer.writeSection(FIRST_EDGE, compact->firstEdge.data(), (nodeCount + 1) * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(EDGES, compact->edges.data(), edgeCount * sizeof(CompactGraph::Edge), offsets, sizes);
+    writer.writeSection(CHAIN_FIRST, compact->chainFirst.data(), (nodeCount + 1) * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(CHAIN_EDGES, compact->chainEdges.data(),
+                        header.chainEdgeCount * sizeof(CompactGraph::Edge), offsets, sizes);
+    writer.writeSection(CHAIN_VIA_FIRST, compact->chainViaFirst.data(),
+                        (header.chainEdgeCount + 1) * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(CHAIN_VIA_NODES, compact->chainViaNodes.data(),
+                        header.chainViaCount * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(CHAIN_VIA_DISTANCES, compact->chainViaOffsets.data(),
+                        header.chainViaCount * sizeof(float), offsets, sizes);
+    writer.writeSection(INTERIOR_NODES, compact->interiorNodes.data(), nodeCount * sizeof(uint8_t), offsets, sizes);
+    writer.writeSection(REVERSE_FIRST, compact->reverseFirst.data(), (nodeCount + 1) * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(REVERSE_EDGES, compact->reverseEdges.data(),
+                        header.reverseEdgeCount * sizeof(CompactGraph::ReverseEdge), offsets, sizes);
+    writer.writeSection(EDGE_NAMES, edgeNames, offsets, sizes);
+    writer.writeSection(EDGE_FLAGS, edgeFlags, offsets, sizes);
+    writer.writeSection(NAME_OFFSETS, nameOffsets, offsets, sizes);
+    writer.writeSection(NAME_DATA, nameData.data(), nameData.size(), offsets, sizes);
+    writer.writeSection(TREE_BOXES, tree ? tree->boxes.data() : nullptr,
+                        header.treeBoxCount * sizeof(SegmentRTree::Box), offsets, sizes);
+    writer.writeSection(TREE_FIRST_CHILD, tree ? tree->firstChild.data() : nullptr,
+                        header.treeBoxCount * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(TREE_LEVEL_ENDS, levelEnds, offsets, sizes);
+    writer.writeSection(TREE_ITEMS, treeItems, offsets, sizes);
+    writer.writeSection(CH_UP_FIRST, hierarchy ? hierarchy->upFirst.data() : nullptr,
+                        hierarchy ? (nodeCount + 1) * sizeof(uint32_t) : 0, offsets, sizes);
+    writer.writeSection(CH_UP_EDGES, hierarchy ? hierarchy->upEdges.data() : nullptr,
+                        header.hierarchyUpCount * sizeof(ContractionHierarchy::Edge), offsets, sizes);
+    writer.writeSection(CH_DOWN_FIRST, hierarchy ? hierarchy->downFirst.data() : nullptr,
+                        hierarchy ? (nodeCount + 1) * sizeof(uint32_t) : 0, offsets, sizes);
+    writer.writeSection(CH_DOWN_EDGES, hierarchy ? hierarchy->downEdges.data() : nullptr,
+                        header.hierarchyDownCount * sizeof(ContractionHierarchy::Edge), offsets, sizes);
+    writer.writeSection(LANDMARK_NODES, landmarks ? landmarks->landmarks.data() : nullptr,
+                        header.landmarkCount * sizeof(uint32_t), offsets, sizes);
+    writer.writeSection(LANDMARK_FROM, landmarks ? landmarks->fromLandmark.data() : nullptr,
+                        nodeCount * header.landmarkCount * sizeof(float), offsets, sizes);
+    writer.writeSection(LANDMARK_TO, landmarks ? landmarks->toLandmark.data() : nullptr,
+                        nodeCount * header.landmarkCount * sizeof(float), offsets, sizes);
+
+    header.fileSize = writer.offset;
+    header.payloadChecksum = writer.payloadChecksum;
+
+    if (std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        writer.failed = true;
+    }
+
+    if (std::fclose(file) != 0 || writer.failed) {
+        LOGE("Failed to write snapshot file %s", tempPath.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to move snapshot into place at %s", path.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    LOGI("Wrote graph snapshot %s (%llu bytes, %zu nodes, %zu edges, %zu names)",
+         path.c_str(), static_cast<unsigned long long>(header.fileSize),
+         nodeCount, edgeCount, static_cast<size_t>(header.nameCount));
+    return true;
+}
+
+std::shared_ptr<const GraphSnapshot> GraphSnapshot::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGI("No graph snapshot at %s", path.c_str());
+        return nullptr;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(sizeof(Header))) {
+        LOGE("Graph snapshot %s is truncated", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        LOGE("Failed to map graph snapshot %s", path.c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<GraphSnapshot> snapshot(new GraphSnapshot());
+    snapshot->mapping = static_cast<const uint8_t*>(data);
+    snapshot->mappingSize = size;
+    snapshot->header = reinterpret_cast<const Header*>(data);
+
+    const Header& header = *snapshot->header;
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != FORMAT_VERSION || header.byteOrder != BYTE_ORDER_MARK) {
+        LOGE("Graph snapshot %s has an unsupported format (version %u)", path.c_str(), header.version);
+        return nullptr;
+    }
+
+    if (header.fileSize != size) {
+        LOGE("Graph snapshot %s size mismatch (%zu != %llu)", path.c_str(), size,
+             static_cast<unsigned long long>(header.fileSize));
+        return nullptr;
+    }
+
+    // The counts come from the file, so a corrupt one must not wrap around into a plausible size.
+    bool overflow = false;
+    auto arrayBytes = [&overflow](uint64_t count, uint64_t elementSize) {
+        uint64_t bytes = 0;
+        overflow |= __builtin_mul_overflow(count, elementSize, &bytes);
+        return bytes;
+    };
+    auto offsetsBytes = [&overflow, &arrayBytes](uint64_t count) {
+        uint64_t entries = 0;
+        overflow |= __builtin_add_overflow(count, 1, &entries);
+        return arrayBytes(entries, sizeof(uint32_t));
+    };
+
+    const uint64_t expectedSizes[SECTION_COUNT] = {
+            arrayBytes(header.nodeCount, sizeof(int64_t)),
+            arrayBytes(header.nodeCount, sizeof(double)),
+            arrayBytes(header.nodeCount, sizeof(double)),
+            offsetsBytes(header.nodeCount),
+            arrayBytes(header.edgeCount, sizeof(CompactGraph::Edge)),
+            offsetsBytes(header.nodeCount),
+            arrayBytes(header.chainEdgeCount, sizeof(CompactGraph::Edge)),
+            offsetsBytes(header.chainEdgeCount),
+            arrayBytes(header.chainViaCount, sizeof(uint32_t)),
+            arrayBytes(header.chainViaCount, sizeof(float)),
+            arrayBytes(header.nodeCount, sizeof(uint8_t)),
+            offsetsBytes(header.nodeCount),
+            arrayBytes(header.reverseEdgeCount, sizeof(CompactGraph::ReverseEdge)),
+            arrayBytes(header.edgeCount, sizeof(uint32_t)),
+            arrayBytes(header.edgeCount, sizeof(uint8_t)),
+            offsetsBytes(header.nameCount),
+            header.sectionSize[NAME_DATA],
+            arrayBytes(header.treeBoxCount, sizeof(SegmentRTree::Box)),
+            arrayBytes(header.treeBoxCount, sizeof(uint32_t)),
+            arrayBytes(header.treeLevelCount, sizeof(uint64_t)),
+            arrayBytes(header.treeItemCount, sizeof(uint32_t)),
+            header.hierarchyNodeCount > 0 ? offsetsBytes(header.hierarchyNodeCount) : 0,
+            arrayBytes(header.hierarchyUpCount, sizeof(ContractionHierarchy::Edge)),
+            header.hierarchyNodeCount > 0 ? offsetsBytes(header.hierarchyNodeCount) : 0,
+            arrayBytes(header.hierarchyDownCount, sizeof(ContractionHierarchy::Edge)),
+            arrayBytes(header.landmarkCount, sizeof(uint32_t)),
+            arrayBytes(arrayBytes(header.nodeCount, header.landmarkCount), sizeof(float)),
+            arrayBytes(arrayBytes(header.nodeCount, header.landmarkCount), sizeof(float))
+    };
+
+    if (overflow) {
+        LOGE("Graph snapshot %s has an impossible element count", path.c_str());
+        return nullptr;
+    }
+
+    for (int id = 0; id < SECTION_COUNT; id++) {
+        uint64_t offset = header.sectionOffset[id];
+        if (header.sectionSize[id] != expectedSizes[id] || offset % 8 != 0 ||
+            offset < sizeof(Header) || offset > size || header.sectionSize[id] > size - offset) {
+            LOGE("Graph snapshot %s has a corrupt section table (section %d)", path.c_str(), id);
+            return nullptr;
+        }
+    }
+
+    uint64_t payloadChecksum = checksum(snapshot->mapping + sizeof(Header), size - sizeof(Header));
+    if (payloadChecksum != header.payloadChecksum) {
+        LOGE("Graph snapshot %s failed checksum validation", path.c_str());
+        return nullptr;
+    }
+
+    // The checksum only guards against damage; every stored index is also checked against the
+    // array it points into so that a bad snapshot is rejected instead of read out of bounds.
+    uint64_t nodeCount = header.nodeCount;
+    uint64_t routingEdgeCount = header.edgeCount + header.chainEdgeCount;
+    auto itself = [](uint32_t value) { return value; };
+    auto edgeTarget = [](const CompactGraph::Edge& edge) { return edge.target; };
+
+    if (!validOffsets(snapshot->firstEdge(), nodeCount, header.edgeCount) ||
+        !validOffsets(snapshot->chainFirst(), nodeCount, header.chainEdgeCount) ||
+        !validOffsets(snapshot->chainViaFirst(), header.chainEdgeCount, header.chainViaCount) ||
+        !validOffsets(snapshot->reverseFirst(), nodeCount, header.reverseEdgeCount)) {
+        LOGE("Graph snapshot %s has inconsistent adjacency offsets", path.c_str());
+        return nullptr;
+    }
+
+    if (!allBelow(snapshot->edges(), header.edgeCount, nodeCount, edgeTarget) ||
+        !allBelow(snapshot->chainEdges(), header.chainEdgeCount, nodeCount, edgeTarget) ||
+        !allBelow(snapshot->chainViaNodes(), header.chainViaCount, nodeCount, itself) ||
+        !allBelow(snapshot->reverseEdges(), header.reverseEdgeCount, nodeCount,
+                  [](const CompactGraph::ReverseEdge& edge) { return edge.source; }) ||
+        !allBelow(snapshot->reverseEdges(), header.reverseEdgeCount, routingEdgeCount,
+                  [](const CompactGraph::ReverseEdge& edge) { return edge.edge; })) {
+        LOGE("Graph snapshot %s has an edge that points outside the graph", path.c_str());
+        return nullptr;
+    }
+
+    if (!validOffsets(snapshot->sectionData<uint32_t>(NAME_OFFSETS), header.nameCount,
+                      header.sectionSize[NAME_DATA]) ||
+        !allBelow(snapshot->edgeNames(), header.edgeCount, header.nameCount, itself)) {
+        LOGE("Graph snapshot %s has an invalid name table", path.c_str());
+        return nullptr;
+    }
+
+    if (header.treeBoxCount > 0) {
+        const uint64_t* levelEnds = snapshot->treeLevelEnds();
+        bool valid = header.treeLevelCount > 0 && levelEnds[0] == header.treeItemCount &&
+                     levelEnds[header.treeLevelCount - 1] == header.treeBoxCount &&
+                     allBelow(snapshot->treeItems(), header.treeItemCount, header.edgeCount, itself);
+        for (uint64_t l = 1; valid && l < header.treeLevelCount; l++) {
+            valid = levelEnds[l - 1] < levelEnds[l];
+        }
+        // Parents are packed after their children, so an inner box points strictly backwards.
+        for (uint64_t b = header.treeItemCount; valid && b < header.treeBoxCount; b++) {
+            valid = snapshot->treeFirstChild()[b] < b;
+        }
+        if (!valid) {
+            LOGE("Graph snapshot %s has an invalid segment tree", path.c_str());
+            return nullptr;
+        }
+    }
+
+    if (header.hierarchyNodeCount > 0) {
+        auto middle = [](const ContractionHierarchy::Edge& edge) {
+            return edge.middle == ContractionHierarchy::NO_MIDDLE ? 0 : edge.middle;
+        };
+        auto hierarchyTarget = [](const ContractionHierarchy::Edge& edge) { return edge.target; };
+        if (header.hierarchyNodeCount != nodeCount ||
+            !validOffsets(snapshot->hierarchyUpFirst(), nodeCount, header.hierarchyUpCount) ||
+            !validOffsets(snapshot->hierarchyDownFirst(), nodeCount, header.hierarchyDownCount) ||
+            !allBelow(snapshot->hierarchyUpEdges(), header.hierarchyUpCount, nodeCount, hierarchyTarget) ||
+            !allBelow(snapshot->hierarchyDownEdges(), header.hierarchyDownCount, nodeCount, hierarchyTarget) ||
+            !allBelow(snapshot->hierarchyUpEdges(), header.hierarchyUpCount, nodeCount, middle) ||
+            !allBelow(snapshot->hierarchyDownEdges(), header.hierarchyDownCount, nodeCount, middle)) {
+            LOGE("Graph snapshot %s has an inconsistent contraction hierarchy", path.c_str());
+            return nullptr;
+        }
+    }
+
+    if (!allBelow(snapshot->landmarkNodes(), header.landmarkCount, nodeCount, itself)) {
+        LOGE("Graph snapshot %s has an invalid landmark", path.c_str());
+        return nullptr;
+    }
+
+    LOGI("Mapped graph snapshot %s (%zu bytes)", path.c_str(), size);
+    return snapshot;
+}
+
+uint64_t GraphSnapshot::checksum(const void* data, size_t size, uint64_t seed) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+uint64_t GraphSnapshot::fingerprintBuffer(const void* data, size_t size) {
+    uint64_t identity[2] = {RoadGraph::BUILDER_VERSION, size};
+    return checksum(data, size, checksum(identity, sizeof(identity)));
+}
+
+uint64_t GraphSnapshot::getSourceFingerprint() const {
+    return header->sourceFingerprint;
+}
+
+size_t GraphSnapshot::getNodesCount() const {
+    return static_cast<size_t>(header->nodeCount);
+}
+
+size_t GraphSnapshot::getEdgesCount() const {
+    return static_cast<size_t>(header->edgeCount);
+}
+
+size_t GraphSnapshot::getChainEdgesCount() const {
+    return static_cast<size_t>(header->chainEdgeCount);
+}
+
+size_t GraphSnapshot::getChainViaNodesCount() const {
+    return static_cast<size_t>(header->chainViaCount);
+}
+
+size_t GraphSnapshot::getReverseEdgesCount() const {
+    return static_cast<size_t>(header->reverseEdgeCount);
+}
+
+size_t GraphSnapshot::getNamesCount() const {
+    return static_cast<size_t>(header->nameCount);
+}
+
+size_t GraphSnapshot::getTreeBoxesCount() const {
+    return static_cast<size_t>(header->treeBoxCount);
+}
+
+size_t GraphSnapshot::getTreeLevelsCount() const {
+    return static_cast<size_t>(header->treeLevelCount);
+}
+
+size_t GraphSnapshot::getHierarchyNodesCount() const {
+    return static_cast<size_t>(header->hierarchyNodeCount);
+}
+
+size_t GraphSnapshot::getHierarchyUpEdgesCount() const {
+    return static_cast<size_t>(header->hierarchyUpCount);
+}
+
+size_t GraphSnapshot::getHierarchyDownEdgesCount() const {
+    return static_cast<size_t>(header->hierarchyDownCount);
+}
+
+size_t GraphSnapshot::getLandmarksCount() const {
+    return static_cast<size_t>(header->landmarkCount);
+}
+
+std::string_view GraphSnapshot::name(uint32_t index) const {
+    const uint32_t* offsets = sectionData<uint32_t>(NAME_OFFSETS);
+    const char* names = sectionData<char>(NAME_DATA);
+    return std::string_view(names + offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+const void* GraphSnapshot::section(Section id) const {
+    return mapping + header->sectionOffset[id];
+}
@@ -0,0 +1,127 @@
+/*
+ * File: graph_snapshot.h
+ * Description: Header file for the GraphSnapshot class, defining the versioned binary snapshot format of a frozen road graph.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "compact_graph.h"
+#include "contraction_hierarchy.h"
+#include "landmark_index.h"
+#include "road_graph.h"
+#include "segment_rtree.h"
+
+class GraphSnapshot {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 4;
+
+    enum Section {
+        NODE_IDS,
+        NODE_LATITUDES,
+        NODE_LONGITUDES,
+        FIRST_EDGE,
+        EDGES,
+        CHAIN_FIRST,
+        CHAIN_EDGES,
+        CHAIN_VIA_FIRST,
+        CHAIN_VIA_NODES,
+        CHAIN_VIA_DISTANCES,
+        INTERIOR_NODES,
+        REVERSE_FIRST,
+        REVERSE_EDGES,
+        EDGE_NAMES,
+        EDGE_FLAGS,
+        NAME_OFFSETS,
+        NAME_DATA,
+        TREE_BOXES,
+        TREE_FIRST_CHILD,
+        TREE_LEVEL_ENDS,
+        TREE_ITEMS,
+        CH_UP_FIRST,
+        CH_UP_EDGES,
+        CH_DOWN_FIRST,
+        CH_DOWN_EDGES,
+        LANDMARK_NODES,
+        LANDMARK_FROM,
+        LANDMARK_TO,
+        SECTION_COUNT
+    };
+
+    static constexpr uint8_t EDGE_FLAG_ONEWAY = 0x01;
+
+    ~GraphSnapshot();
+
+    static bool write(const std::string& path, const RoadGraph& graph, uint64_t sourceFingerprint);
+
+    static std::shared_ptr<const GraphSnapshot> open(const std::string& path);
+
+    static uint64_t checksum(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL);
+
+    // Identifies the source data together with the builder that turns it into a graph.
+    static uint64_t fingerprintBuffer(const void* data, size_t size);
+
+    uint64_t getSourceFingerprint() const;
+
+    size_t getNodesCount() const;
+    size_t getEdgesCount() const;
+    size_t getChainEdgesCount() const;
+    size_t getChainViaNodesCount() const;
+    size_t getReverseEdgesCount() const;
+    size_t getNamesCount() const;
+    size_t getTreeBoxesCount() const;
+    size_t getTreeLevelsCount() const;
+    size_t getHierarchyNodesCount() const;
+    size_t getHierarchyUpEdgesCount() const;
+    size_t getHierarchyDownEdgesCount() const;
+    size_t getLandmarksCount() const;
+
+    const int64_t* nodeIds() const { return sectionData<int64_t>(NODE_IDS); }
+    const double* nodeLatitudes() const { return sectionData<double>(NODE_LATITUDES); }
+    const double* nodeLongitudes() const { return sectionData<double>(NODE_LONGITUDES); }
+    const uint32_t* firstEdge() const { return sectionData<uint32_t>(FIRST_EDGE); }
+    const CompactGraph::Edge* edges() const { return sectionData<CompactGraph::Edge>(EDGES); }
+    const uint32_t* chainFirst() const { return sectionData<uint32_t>(CHAIN_FIRST); }
+    const CompactGraph::Edge* chainEdges() const { return sectionData<CompactGraph::Edge>(CHAIN_EDGES); }
+    const uint32_t* chainViaFirst() const { return sectionData<uint32_t>(CHAIN_VIA_FIRST); }
+    const uint32_t* chainViaNodes() const { return sectionData<uint32_t>(CHAIN_VIA_NODES); }
+    const float* chainViaDistances() const { return sectionData<float>(CHAIN_VIA_DISTANCES); }
+    const uint8_t* interiorNodes() const { return sectionData<uint8_t>(INTERIOR_NODES); }
+    const uint32_t* reverseFirst() const { return sectionData<uint32_t>(REVERSE_FIRST); }
+    const CompactGraph::ReverseEdge* reverseEdges() const { return sectionData<CompactGraph::ReverseEdge>(REVERSE_EDGES); }
+    const uint32_t* edgeNames() const { return sectionData<uint32_t>(EDGE_NAMES); }
+    const uint8_t* edgeFlags() const { return sectionData<uint8_t>(EDGE_FLAGS); }
+    const SegmentRTree::Box* treeBoxes() const { return sectionData<SegmentRTree::Box>(TREE_BOXES); }
+    const uint32_t* treeFirstChild() const { return sectionData<uint32_t>(TREE_FIRST_CHILD); }
+    const uint64_t* treeLevelEnds() const { return sectionData<uint64_t>(TREE_LEVEL_ENDS); }
+    const uint32_t* treeItems() const { return sectionData<uint32_t>(TREE_ITEMS); }
+    const uint32_t* hierarchyUpFirst() const { return sectionData<uint32_t>(CH_UP_FIRST); }
+    const ContractionHierarchy::Edge* hierarchyUpEdges() const { return sectionData<ContractionHierarchy::Edge>(CH_UP_EDGES); }
+    const uint32_t* hierarchyDownFirst() const { return sectionData<uint32_t>(CH_DOWN_FIRST); }
+    const ContractionHierarchy::Edge* hierarchyDownEdges() const { return sectionData<ContractionHierarchy::Edge>(CH_DOWN_EDGES); }
+    const uint32_t* landmarkNodes() const { return sectionData<uint32_t>(LANDMARK_NODES); }
+    const float* landmarkFromDistances() const { return sectionData<float>(LANDMARK_FROM); }
+    const float* landmarkToDistances() const { return sectionData<float>(LANDMARK_TO); }
+
+    std::string_view name(uint32_t index) const;
+
+private:
+    struct Header;
+
+    GraphSnapshot() = default;
+
+    const uint8_t* mapping = nullptr;
+    size_t mappingSize = 0;
+    const Header* header = nullptr;
+
+    const void* section(Section id) const;
+
+    template <typename T>
+    const T* sectionData(Section id) const { return static_cast<const T*>(section(id)); }
+};
@@ -0,0 +1,265 @@
+/*
+ * File: hmm_map_matcher.cpp
+ * Description: Implementation of the HmmMapMatcher class, responsible for candidate columns, transition distances and online Viterbi decoding.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "hmm_map_matcher.h"
+#include "search_workspace.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define LOG_TAG "HmmMapMatcher"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr double DEFAULT_GPS_SIGMA = 10.0;
+constexpr double MIN_GPS_SIGMA = 4.0;
+constexpr double BEARING_SIGMA = 20.0;
+constexpr double MIN_BEARING_SPEED = 2.0;
+constexpr double TRANSITION_BETA = 10.0;
+constexpr double MAX_BACKTRACK = 15.0;
+constexpr double MAX_FIX_GAP = 1000.0;
+constexpr size_t MAX_CACHED_REACH_ENTRIES = 1 << 18;
+constexpr double REACH_STEP = 50.0;
+constexpr double ROUTE_LIMIT_FACTOR = 2.0;
+constexpr double ROUTE_LIMIT_SLACK = 100.0;
+constexpr double NEGATIVE_INFINITY = -std::numeric_limits<double>::infinity();
+
+double segmentBearing(const RoadSegment* segment) {
+    double lat1 = segment->start->latitude * M_PI / 180.0;
+    double lat2 = segment->end->latitude * M_PI / 180.0;
+    double dLon = (segment->end->longitude - segment->start->longitude) * M_PI / 180.0;
+    double y = std::sin(dLon) * std::cos(lat2);
+    double x = std::cos(lat1) * std::sin(lat2) - std::sin(lat1) * std::cos(lat2) * std::cos(dLon);
+    return std::fmod(std::atan2(y, x) * 180.0 / M_PI + 360.0, 360.0);
+}
+
+}
+
+HmmMapMatcher::HmmMapMatcher(RoadGraph* graph)
+        : roadGraph(graph) {
+}
+
+void HmmMapMatcher::reset() {
+    previousColumn.clear();
+    lastFix.reset();
+    reachCache.clear();
+    reachCacheEntries = 0;
+}
+
+HmmMapMatcher::Candidate HmmMapMatcher::project(const Location& loc, RoadSegment* segment) {
+    // Planar projection with longitudes scaled to the local latitude.
+    double scale = std::cos(loc.latitude * M_PI / 180.0);
+    double dx = (segment->end->longitude - segment->start->longitude) * scale;
+    double dy = segment->end->latitude - segment->start->latitude;
+    double px = (loc.longitude - segment->start->longitude) * scale;
+    double py = loc.latitude - segment->start->latitude;
+
+    double lengthSquared = dx * dx + dy * dy;
+    double fraction = lengthSquared > 1e-18 ? std::clamp((px * dx + py * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+
+    Candidate candidate;
+    candidate.segment = segment;
+    candidate.fraction = fraction;
+    candidate.latitude = segment->start->latitude + fraction * (segment->end->latitude - segment->start->latitude);
+    candidate.longitude = segment->start->longitude + fraction * (segment->end->longitude - segment->start->longitude);
+    candidate.distance = RoadGraph::haversineDistance(loc.latitude, loc.longitude,
+                                                      candidate.latitude, candidate.longitude);
+    return candidate;
+}
+
+double HmmMapMatcher::emissionScore(const Location& loc, const Candidate& candidate) {
+    double sigma = loc.accuracy > 0.0f ? std::max(static_cast<double>(loc.accuracy), MIN_GPS_SIGMA)
+                                       : DEFAULT_GPS_SIGMA;
+    double score = -0.5 * (candidate.distance / sigma) * (candidate.distance / sigma);
+
+    // While moving, the heading separates the two directions of a two-way road.
+    if (loc.speed > MIN_BEARING_SPEED) {
+        double bearingDiff = std::abs(segmentBearing(candidate.segment) - loc.bearing);
+        if (bearingDiff > 180.0) {
+            bearingDiff = 360.0 - bearingDiff;
+        }
+        score -= 0.5 * (bearingDiff / BEARING_SIGMA) * (bearingDiff / BEARING_SIGMA);
+    }
+    return score;
+}
+
+double HmmMapMatcher::transitionScore(double routeDistance, double fixDistance) {
+    return -std::abs(routeDistance - fixDistance) / TRANSITION_BETA;
+}
+
+double HmmMapMatcher::routeLimit(double fixDistance) {
+    return ROUTE_LIMIT_FACTOR * fixDistance + ROUTE_LIMIT_SLACK;
+}
+
+std::optional<HmmMapMatcher::Candidate> HmmMapMatcher::update(const Location& loc,
+                                                              const std::vector<RoadSegment*>& segments) {
+    collectCandidates(loc, segments);
+    if (candidates.empty()) {
+        previousColumn.clear();
+        return std::nullopt;
+    }
+
+    double fixDistance = lastFix ? RoadGraph::haversineDistance(lastFix->latitude, lastFix->longitude,
+                                                                loc.latitude, loc.longitude) : 0.0;
+    lastFix = loc;
+
+    column.clear();
+    for (const Candidate& candidate : candidates) {
+        column.push_back(State{candidate, NEGATIVE_INFINITY});
+    }
+
+    if (!previousColumn.empty() && fixDistance <= MAX_FIX_GAP) {
+        double limit = routeLimit(fixDistance);
+        for (const State& previous : previousColumn) {
+            routeDistances(previous.candidate, candidates, limit, distances);
+            for (size_t j = 0; j < candidates.size(); j++) {
+                if (!std::isinf(distances[j])) {
+                    column[j].score = std::max(column[j].score,
+                                               previous.score + transitionScore(distances[j], fixDistance));
+                }
+            }
+        }
+    }
+
+    bool connected = std::any_of(column.begin(), column.end(), [](const State& state) {
+        return !std::isinf(state.score);
+    });
+    if (!connected && !previousColumn.empty()) {
+        // No candidate is reachable from the previous fix: the trace has a break.
+        LOGD("No transition between fixes %.0f m apart, starting a new path", fixDistance);
+    }
+
+    double best = NEGATIVE_INFINITY;
+    for (State& state : column) {
+        state.score = (connected ? state.score : 0.0) + emissionScore(loc, state.candidate);
+        best = std::max(best, state.score);
+    }
+
+    // Scores are log-probabilities relative to the best state, which keeps them bounded.
+    for (State& state : column) {
+        state.score -= best;
+    }
+
+    std::swap(previousColumn, column);
+    return std::max_element(previousColumn.begin(), previousColumn.end(), [](const State& a, const State& b) {
+        return a.score < b.score;
+    })->candidate;
+}
+
+void HmmMapMatcher::collectCandidates(const Location& loc, const std::vector<RoadSegment*>& segments) {
+    candidates.clear();
+    for (RoadSegment* segment : segments) {
+        candidates.push_back(project(loc, segment));
+    }
+
+    if (candidates.size() > MAX_CANDIDATES) {
+        std::nth_element(candidates.begin(), candidates.begin() + MAX_CANDIDATES, candidates.end(),
+                         [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+        candidates.resize(MAX_CANDIDATES);
+    }
+}
+
+void HmmMapMatcher::routeDistances(const Candidate& from, const std::vector<Candidate>& to, double limit,
+                                   std::vector<double>& result) {
+    result.assign(to.size(), std::numeric_limits<double>::infinity());
+
+    // Staying on the same directed segment needs no search. Projections of noisy fixes jitter
+    // backwards too, which is taken as a short move rather than a loop around the block.
+    size_t remaining = 0;
+    for (size_t j = 0; j < to.size(); j++) {
+        double advance = to[j].segment == from.segment
+                         ? (to[j].fraction - from.fraction) * from.segment->length
+                         : -std::numeric_limits<double>::infinity();
+        if (advance >= -MAX_BACKTRACK) {
+            result[j] = std::abs(advance);
+        } else {
+            remaining++;
+        }
+    }
+    if (remaining == 0) {
+        return;
+    }
+
+    double offset = (1.0 - from.fraction) * from.segment->length;
+    if (offset > limit) {
+        return;
+    }
+
+    const Reach& reach = reachFrom(from.segment->end->index, limit - offset);
+    for (size_t j = 0; j < to.size(); j++) {
+        if (!std::isinf(result[j])) {
+            continue;
+        }
+        uint32_t target = to[j].segment->start->index;
+        auto it = std::lower_bound(reach.nodes.begin(), reach.nodes.end(), target,
+                                   [](const NodeDistance& entry, uint32_t node) { return entry.node < node; });
+        if (it != reach.nodes.end() && it->node == target) {
+            result[j] = offset + it->distance + to[j].fraction * to[j].segment->length;
+        }
+    }
+}
+
+const HmmMapMatcher::Reach& HmmMapMatcher::reachFrom(uint32_t source, double limit) {
+    // Only a reload invalidates the searches; endpoint splits never shorten a path and their
+    // segments are not indexed, so they never become candidates.
+    if (reachCacheGeneration != roadGraph->getGeneration()) {
+        reachCache.clear();
+        reachCacheEntries = 0;
+        reachCacheGeneration = roadGraph->getGeneration();
+    }
+
+    auto cached = reachCache.find(source);
+    if (cached != reachCache.end()) {
+        if (cached->second.limit >= limit) {
+            return cached->second;
+        }
+        reachCacheEntries -= cached->second.nodes.size();
+    }
+    if (reachCacheEntries >= MAX_CACHED_REACH_ENTRIES) {
+        reachCache.clear();
+        reachCacheEntries = 0;
+    }
+
+    // Bounded Dijkstra over the node adjacency, keeping every node it settles.
+    SearchWorkspace& workspace = SearchWorkspace::forThread();
+    workspace.reset(roadGraph->getNodesCount());
+    IndexedHeap& queue = workspace.queue();
+
+    // Rounding the bound up lets later, slightly longer transitions reuse the same search.
+    limit = std::ceil(limit / REACH_STEP) * REACH_STEP;
+    Reach& reach = reachCache[source];
+    reach.limit = limit;
+    reach.nodes.clear();
+
+    workspace.setDistance(source, 0.0, {});
+    queue.push(source, 0.0);
+
+    while (!queue.empty()) {
+        IndexedHeap::Entry current = queue.pop();
+        if (current.key > limit) {
+            break;
+        }
+        workspace.settle(current.node);
+        reach.nodes.push_back(NodeDistance{current.node, current.key});
+
+        for (RoadSegment* segment : roadGraph->getNodeByIndex(current.node)->segments) {
+            uint32_t next = segment->end->index;
+            double distance = current.key + segment->length;
+            if (!workspace.isSettled(next) && distance < workspace.distance(next)) {
+                workspace.setDistance(next, distance, {});
+                queue.push(next, distance);
+            }
+        }
+    }
+
+    std::sort(reach.nodes.begin(), reach.nodes.end(),
+              [](const NodeDistance& a, const NodeDistance& b) { return a.node < b.node; });
+    reachCacheEntries += reach.nodes.size();
+    return reach;
+}
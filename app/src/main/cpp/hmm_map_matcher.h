@@ -0,0 +1,84 @@
+/*
+ * File: hmm_map_matcher.h
+ * Description: Header file for the HmmMapMatcher class, an online hidden Markov model matcher over road segments.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "location_filter.h"
+#include "road_graph.h"
+
+// Each fix keeps up to MAX_CANDIDATES road positions. A position is likely when it lies close to
+// the fix (emission) and when the network distance from the previous position matches the
+// straight-line distance between the fixes (transition). Only the newest fix is ever reported, and
+// the end of the best path is the best state of the newest column, so no older column is kept.
+class HmmMapMatcher {
+public:
+    static constexpr size_t MAX_CANDIDATES = 16;
+
+    struct Candidate {
+        RoadSegment* segment;
+        double fraction;
+        double latitude;
+        double longitude;
+        double distance;
+    };
+
+    explicit HmmMapMatcher(RoadGraph* graph);
+
+    // Adds a fix matched against `segments` (the nearest MAX_CANDIDATES are kept) and returns
+    // the most likely position for it, or nothing when no segment is given.
+    std::optional<Candidate> update(const Location& loc, const std::vector<RoadSegment*>& segments);
+
+    void reset();
+
+    // The position of a fix on a segment and the log-probabilities of the model.
+    static Candidate project(const Location& loc, RoadSegment* segment);
+    static double emissionScore(const Location& loc, const Candidate& candidate);
+    static double transitionScore(double routeDistance, double fixDistance);
+
+private:
+    struct State {
+        Candidate candidate;
+        double score;
+    };
+
+    struct NodeDistance {
+        uint32_t node;
+        double distance;
+    };
+
+    // Every node within `limit` of a source, sorted by node. Consecutive fixes mostly start their
+    // transitions from the same few nodes, so the searches are kept and reused until the graph changes.
+    struct Reach {
+        double limit;
+        std::vector<NodeDistance> nodes;
+    };
+
+    RoadGraph* roadGraph;
+    std::vector<State> previousColumn;
+    std::vector<State> column;
+    std::optional<Location> lastFix;
+    std::vector<Candidate> candidates;
+    std::vector<double> distances;
+    std::unordered_map<uint32_t, Reach> reachCache;
+    size_t reachCacheEntries = 0;
+    uint64_t reachCacheGeneration = 0;
+
+    void collectCandidates(const Location& loc, const std::vector<RoadSegment*>& segments);
+
+    // Network distances from `from` to every candidate in `to`, infinite beyond `limit`.
+    void routeDistances(const Candidate& from, const std::vector<Candidate>& to, double limit,
+                        std::vector<double>& result);
+    const Reach& reachFrom(uint32_t source, double limit);
+
+    // Upper bound on the network distance worth exploring between fixes `fixDistance` apart.
+    static double routeLimit(double fixDistance);
+};
@@ -0,0 +1,110 @@
+/*
+ * File: indexed_heap.h
+ * Description: Header file for the IndexedHeap class, a 4-ary min-heap keyed by dense node id with decrease-key.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Each node is queued at most once: pushing a queued node lowers its key instead of adding a
+// duplicate entry. Positions are cleared per entry, so reset() costs the size of the heap.
+class IndexedHeap {
+public:
+    struct Entry {
+        double key;
+        uint32_t node;
+    };
+
+    void reset(size_t nodeCount) {
+        for (const Entry& entry : entries) {
+            position[entry.node] = NOT_QUEUED;
+        }
+        entries.clear();
+        if (position.size() < nodeCount) {
+            position.resize(nodeCount, NOT_QUEUED);
+        }
+    }
+
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    const Entry& top() const { return entries.front(); }
+    bool contains(uint32_t node) const { return position[node] != NOT_QUEUED; }
+
+    // Inserts the node, or lowers its key when it is already queued with a larger one.
+    void push(uint32_t node, double key) {
+        uint32_t index = position[node];
+        if (index == NOT_QUEUED) {
+            index = static_cast<uint32_t>(entries.size());
+            entries.push_back({key, node});
+        } else if (key < entries[index].key) {
+            entries[index].key = key;
+        } else {
+            return;
+        }
+        siftUp(index, entries[index]);
+    }
+
+    Entry pop() {
+        Entry first = entries.front();
+        position[first.node] = NOT_QUEUED;
+
+        Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            siftDown(0, last);
+        }
+        return first;
+    }
+
+private:
+    static constexpr uint32_t NOT_QUEUED = UINT32_MAX;
+    static constexpr uint32_t ARITY = 4;
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> position;
+
+    void place(uint32_t index, const Entry& entry) {
+        entries[index] = entry;
+        position[entry.node] = index;
+    }
+
+    void siftUp(uint32_t index, Entry entry) {
+        while (index > 0) {
+            uint32_t parent = (index - 1) / ARITY;
+            if (entries[parent].key <= entry.key) {
+                break;
+            }
+            place(index, entries[parent]);
+            index = parent;
+        }
+        place(index, entry);
+    }
+
+    void siftDown(uint32_t index, Entry entry) {
+        uint32_t count = static_cast<uint32_t>(entries.size());
+        while (true) {
+            uint32_t first = index * ARITY + 1;
+            if (first >= count) {
+                break;
+            }
+            uint32_t last = first + ARITY < count ? first + ARITY : count;
+            uint32_t smallest = first;
+            for (uint32_t child = first + 1; child < last; child++) {
+                if (entries[child].key < entries[smallest].key) {
+                    smallest = child;
+                }
+            }
+            if (entries[smallest].key >= entry.key) {
+                break;
+            }
+            place(index, entries[smallest]);
+            index = smallest;
+        }
+        place(index, entry);
+    }
+};
@@ -0,0 +1,219 @@
+/*
+ * File: landmark_index.cpp
+ * Description: Implementation of the LandmarkIndex class, responsible for landmark selection, distance tables and triangle-inequality bounds.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "landmark_index.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#define LOG_TAG "LandmarkIndex"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+struct Adjacent {
+    uint32_t node;
+    float length;
+};
+
+struct Adjacency {
+    std::vector<uint32_t> first;
+    std::vector<Adjacent> edges;
+};
+
+void shortestLengths(const Adjacency& adjacency, uint32_t source, std::vector<float>& distance) {
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+    std::fill(distance.begin(), distance.end(), UNREACHABLE);
+    distance[source] = 0.0f;
+    queue.push({0.0f, source});
+
+    while (!queue.empty()) {
+        Entry current = queue.top();
+        queue.pop();
+        if (current.first > distance[current.second]) {
+            continue;
+        }
+
+        for (uint32_t e = adjacency.first[current.second]; e < adjacency.first[current.second + 1]; e++) {
+            const Adjacent& next = adjacency.edges[e];
+            float candidate = current.first + next.length;
+            if (candidate < distance[next.node]) {
+                distance[next.node] = candidate;
+                queue.push({candidate, next.node});
+            }
+        }
+    }
+}
+
+}
+
+void LandmarkIndex::build(const CompactGraph& graph, size_t landmarkCount) {
+    auto buildStart = std::chrono::steady_clock::now();
+
+    uint32_t count = graph.getBaseNodesCount();
+    Adjacency forward;
+    Adjacency backward;
+    forward.first.assign(count + 1, 0);
+    backward.first.assign(count + 1, 0);
+
+    for (uint32_t n = 0; n < count; n++) {
+        for (uint32_t e = graph.firstEdge[n]; e < graph.firstEdge[n + 1]; e++) {
+            forward.first[n + 1]++;
+            backward.first[graph.edges[e].target + 1]++;
+        }
+    }
+    for (uint32_t n = 0; n < count; n++) {
+        forward.first[n + 1] += forward.first[n];
+        backward.first[n + 1] += backward.first[n];
+    }
+
+    forward.edges.resize(forward.first[count]);
+    backward.edges.resize(backward.first[count]);
+    std::vector<uint32_t> forwardCursor(forward.first.begin(), forward.first.end() - 1);
+    std::vector<uint32_t> backwardCursor(backward.first.begin(), backward.first.end() - 1);
+    for (uint32_t n = 0; n < count; n++) {
+        for (uint32_t e = graph.firstEdge[n]; e < graph.firstEdge[n + 1]; e++) {
+            const CompactGraph::Edge& edge = graph.edges[e];
+            forward.edges[forwardCursor[n]++] = Adjacent{edge.target, edge.length};
+            backward.edges[backwardCursor[edge.target]++] = Adjacent{n, edge.length};
+        }
+    }
+
+    // Isolated nodes would make useless landmarks.
+    std::vector<bool> candidate(count);
+    uint32_t firstCandidate = CompactGraph::INVALID_NODE;
+    for (uint32_t n = 0; n < count; n++) {
+        candidate[n] = forward.first[n + 1] > forward.first[n] || backward.first[n + 1] > backward.first[n];
+        if (candidate[n] && firstCandidate == CompactGraph::INVALID_NODE) {
+            firstCandidate = n;
+        }
+    }
+
+    std::vector<uint32_t> chosen;
+    std::vector<float> fromTable;
+    std::vector<float> toTable;
+    std::vector<std::vector<float>> fromColumns;
+    std::vector<std::vector<float>> toColumns;
+
+    if (firstCandidate != CompactGraph::INVALID_NODE && landmarkCount > 0) {
+        // Farthest selection: start from the node farthest from an arbitrary one, then repeatedly
+        // take the node farthest from every landmark chosen so far (unreached nodes first).
+        std::vector<float> nearest(count, UNREACHABLE);
+        std::vector<float> distance(count);
+        shortestLengths(forward, firstCandidate, distance);
+
+        uint32_t next = firstCandidate;
+        for (uint32_t n = 0; n < count; n++) {
+            if (candidate[n] && distance[n] != UNREACHABLE && distance[n] > distance[next]) {
+                next = n;
+            }
+        }
+
+        while (chosen.size() < landmarkCount && next != CompactGraph::INVALID_NODE) {
+            chosen.push_back(next);
+            fromColumns.emplace_back(count);
+            toColumns.emplace_back(count);
+            shortestLengths(forward, next, fromColumns.back());
+            shortestLengths(backward, next, toColumns.back());
+
+            next = CompactGraph::INVALID_NODE;
+            float farthest = 0.0f;
+            for (uint32_t n = 0; n < count; n++) {
+                nearest[n] = std::min({nearest[n], fromColumns.back()[n], toColumns.back()[n]});
+                if (candidate[n] && nearest[n] > farthest) {
+                    farthest = nearest[n];
+                    next = n;
+                }
+            }
+        }
+
+        size_t chosenCount = chosen.size();
+        fromTable.resize(static_cast<size_t>(count) * chosenCount);
+        toTable.resize(static_cast<size_t>(count) * chosenCount);
+        for (uint32_t n = 0; n < count; n++) {
+            for (size_t l = 0; l < chosenCount; l++) {
+                fromTable[n * chosenCount + l] = fromColumns[l][n];
+                toTable[n * chosenCount + l] = toColumns[l][n];
+            }
+        }
+    }
+
+    landmarks.assign(std::move(chosen));
+    fromLandmark.assign(std::move(fromTable));
+    toLandmark.assign(std::move(toTable));
+    nodeCount = count;
+    backingStorage.reset();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - buildStart).count();
+    LOGI("Selected %zu landmarks over %u nodes in %lld ms",
+         landmarks.size(), count, static_cast<long long>(elapsed));
+}
+
+void LandmarkIndex::attach(const uint32_t* landmarkNodes, size_t landmarkCount,
+                           const float* fromDistances, const float* toDistances, size_t count,
+                           std::shared_ptr<const void> storage) {
+    landmarks.attach(landmarkNodes, landmarkCount);
+    fromLandmark.attach(fromDistances, count * landmarkCount);
+    toLandmark.attach(toDistances, count * landmarkCount);
+    nodeCount = count;
+    backingStorage = std::move(storage);
+
+    LOGI("Attached %zu landmarks over %zu nodes", landmarkCount, count);
+}
+
+double LandmarkIndex::lowerBound(const CompactGraph& graph, uint32_t from, uint32_t to) const {
+    if (from == to || landmarks.empty()) {
+        return 0.0;
+    }
+
+    double bound = std::numeric_limits<double>::infinity();
+    if (from >= nodeCount) {
+        graph.forEachEdge(from, [&](const CompactGraph::Edge& edge, uint32_t) {
+            double rest = edge.target == to ? 0.0 :
+                          edge.target < nodeCount ? lowerBound(graph, edge.target, to) : 0.0;
+            bound = std::min(bound, edge.length + rest);
+        });
+    } else if (to >= nodeCount) {
+        graph.forEachOverlayEdgeInto(to, [&](uint32_t source, const CompactGraph::Edge& edge, uint32_t) {
+            double rest = source == from ? 0.0 : source < nodeCount ? baseBound(from, source) : 0.0;
+            bound = std::min(bound, rest + edge.length);
+        });
+    } else {
+        return baseBound(from, to);
+    }
+
+    return std::isinf(bound) ? 0.0 : bound;
+}
+
+double LandmarkIndex::baseBound(uint32_t from, uint32_t to) const {
+    size_t count = landmarks.size();
+    const float* fromRow = fromLandmark.data() + from * count;
+    const float* toRow = fromLandmark.data() + to * count;
+    const float* fromBack = toLandmark.data() + from * count;
+    const float* toBack = toLandmark.data() + to * count;
+
+    // d(L, to) <= d(L, from) + d(from, to) and d(from, L) <= d(from, to) + d(to, L).
+    float bound = 0.0f;
+    for (size_t l = 0; l < count; l++) {
+        if (fromRow[l] != UNREACHABLE && toRow[l] != UNREACHABLE) {
+            bound = std::max(bound, toRow[l] - fromRow[l]);
+        }
+        if (fromBack[l] != UNREACHABLE && toBack[l] != UNREACHABLE) {
+            bound = std::max(bound, fromBack[l] - toBack[l]);
+        }
+    }
+    return bound;
+}
@@ -0,0 +1,48 @@
+/*
+ * File: landmark_index.h
+ * Description: Header file for the LandmarkIndex class, precomputed landmark distances that give A* tight lower bounds (ALT).
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "compact_graph.h"
+#include "packed_array.h"
+
+class LandmarkIndex {
+public:
+    static constexpr size_t DEFAULT_LANDMARK_COUNT = 16;
+
+    LandmarkIndex() = default;
+
+    // Picks landmarks by farthest selection and stores shortest lengths to and from each of them.
+    void build(const CompactGraph& graph, size_t landmarkCount = DEFAULT_LANDMARK_COUNT);
+
+    void attach(const uint32_t* landmarkNodes, size_t landmarkCount,
+                const float* fromDistances, const float* toDistances, size_t nodeCount,
+                std::shared_ptr<const void> storage);
+
+    // Lower bound on the length of any route from `from` to `to`. Nodes appended after the
+    // index was built are bounded through their overlay edges.
+    double lowerBound(const CompactGraph& graph, uint32_t from, uint32_t to) const;
+
+    size_t getLandmarksCount() const { return landmarks.size(); }
+    size_t getNodesCount() const { return nodeCount; }
+
+private:
+    friend class GraphSnapshot;
+
+    // Node-major tables: the distances of node v start at v * getLandmarksCount().
+    PackedArray<uint32_t> landmarks;
+    PackedArray<float> fromLandmark;
+    PackedArray<float> toLandmark;
+    size_t nodeCount = 0;
+    std::shared_ptr<const void> backingStorage;
+
+    double baseBound(uint32_t from, uint32_t to) const;
+};
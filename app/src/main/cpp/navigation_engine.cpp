@@ -6,6 +6,8 @@
  */
 
 #include "navigation_engine.h"
+#include "graph_snapshot.h"
+#include "thread_pool.h"
 #include <android/log.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
@@ -61,7 +63,9 @@ double NavigationEngine::haversineDistance(double lat1, double lon1, double lat2
 NavigationEngine::NavigationEngine() {
     LOGI("Creating NavigationEngine");
     try {
-        roadGraph      = std::make_unique<RoadGraph>();
+        // The map is loaded while the UI is starting up, so one hardware thread is left to it.
+        size_t loaderThreads = std::max<size_t>(1, ThreadPool::defaultThreadCount() - 1);
+        roadGraph      = std::make_unique<RoadGraph>(loaderThreads);
         routingEngine  = std::make_unique<RoutingEngine>(roadGraph.get());
         routeMatcher   = std::make_unique<RouteMatcher>(roadGraph.get());
         locationFilter = std::make_unique<LocationFilter>();
@@ -96,75 +100,74 @@ bool NavigationEngine::loadOSMFromAssets(AAssetManager* assetManager, const std:
         return false;
     }
 
-    char* buffer = (char*)malloc(fileSize + 1);
-    if (!buffer) {
-        LOGE("Failed to allocate memory for asset");
-        AAsset_close(asset);
-        return false;
-    }
-
-    const size_t CHUNK_SIZE = 1024 * 1024;
-    size_t totalRead = 0;
-    size_t bytesRead = 0;
-    int lastProgressPercent = 0;
-
-    while (totalRead < fileSize) {
-        size_t bytesToRead = std::min(CHUNK_SIZE, static_cast<size_t>(fileSize) - totalRead);
-        bytesRead = AAsset_read(asset, buffer + totalRead, bytesToRead);
+    // AASSET_MODE_BUFFER maps uncompressed assets straight from the APK, so this is usually not a copy.
+    const char* data = static_cast<const char*>(AAsset_getBuffer(asset));
+    char* fallbackBuffer = nullptr;
+    size_t dataSize = static_cast<size_t>(fileSize);
 
-        if (bytesRead <= 0) {
-            LOGE("Failed to read chunk from asset");
-            break;
+    if (!data) {
+        LOGI("Asset buffer unavailable, reading asset into memory");
+        fallbackBuffer = (char*)malloc(dataSize);
+        if (!fallbackBuffer) {
+            LOGE("Failed to allocate memory for asset");
+            AAsset_close(asset);
+            return false;
         }
 
-        totalRead += bytesRead;
+        const size_t CHUNK_SIZE = 1024 * 1024;
+        size_t totalRead = 0;
+        int lastProgressPercent = 0;
 
-        int progressPercent = (totalRead * 100) / fileSize;
-        if (progressPercent - lastProgressPercent >= 5) {
-            LOGI("Reading OSM file: %d%% complete", progressPercent);
-            lastProgressPercent = progressPercent;
-        }
-    }
-    buffer[totalRead] = '\0';
-    std::string tempFilePath = "/data/data/com.example.navigation/temp_osm_file";
+        while (totalRead < dataSize) {
+            size_t bytesToRead = std::min(CHUNK_SIZE, dataSize - totalRead);
+            int bytesRead = AAsset_read(asset, fallbackBuffer + totalRead, bytesToRead);
 
-    FILE* tempFile = fopen(tempFilePath.c_str(), "wb");
-    if (!tempFile) {
-        LOGE("Failed to create temporary file");
-        free(buffer);
-        AAsset_close(asset);
-        return false;
-    }
+            if (bytesRead <= 0) {
+                LOGE("Failed to read chunk from asset");
+                break;
+            }
 
-    size_t bytesWritten = fwrite(buffer, 1, totalRead, tempFile);
-    fclose(tempFile);
+            totalRead += bytesRead;
 
-    if (bytesWritten != totalRead) {
-        LOGE("Failed to write all data to temporary file");
-        free(buffer);
-        AAsset_close(asset);
-        return false;
+            int progressPercent = (totalRead * 100) / dataSize;
+            if (progressPercent - lastProgressPercent >= 5) {
+                LOGI("Reading OSM file: %d%% complete", progressPercent);
+                lastProgressPercent = progressPercent;
+            }
+        }
+
+        data = fallbackBuffer;
+        dataSize = totalRead;
     }
 
-    free(buffer);
-    AAsset_close(asset);
+    uint64_t sourceFingerprint = GraphSnapshot::fingerprintBuffer(data, dataSize);
+    std::string snapshotPath = "/data/data/com.example.navigation/" + fileName + ".snapshot";
 
-    bool success = roadGraph->loadOSMData(tempFilePath);
+    bool success = false;
 
-    if (success) {
+    if (roadGraph->loadSnapshot(snapshotPath, sourceFingerprint)) {
+        LOGI("Loaded road graph from snapshot. Nodes: %zu, Segments: %zu",
+             roadGraph->getNodesCount(), roadGraph->getSegmentsCount());
+        success = roadGraph->getNodesCount() > 0 && roadGraph->getSegmentsCount() > 0;
+    } else if (roadGraph->loadOSMBuffer(data, dataSize)) {
         size_t nodeCount = roadGraph->getNodesCount();
         size_t segCount  = roadGraph->getSegmentsCount();
         LOGI("OSM data load success. Nodes: %zu, Segments: %zu", nodeCount, segCount);
 
         if (nodeCount == 0 || segCount == 0) {
             LOGE("OSM data loaded but contains no nodes or segments");
-            success = false;
+        } else {
+            success = true;
+            if (!roadGraph->saveSnapshot(snapshotPath, sourceFingerprint)) {
+                LOGE("Failed to write graph snapshot, next start will parse OSM data again");
+            }
         }
     } else {
         LOGE("Failed to parse OSM data");
     }
 
-    remove(tempFilePath.c_str());
+    free(fallbackBuffer);
+    AAsset_close(asset);
     return success;
 }
 
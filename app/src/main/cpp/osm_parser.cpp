@@ -6,13 +6,18 @@
  */
 
 #include "osm_parser.h"
+#include "osm_pbf_reader.h"
+#include "osm_xml_reader.h"
+#include "thread_pool.h"
 #include <android/log.h>
-#include <fstream>
-#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
 #include <cmath>
-#include <random>
-#include <pugixml.hpp>
 
 #define LOG_TAG "OSMParser"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -21,78 +26,142 @@
 
 extern void reportLoadingProgress(int progress);
 
-OSMParser::OSMParser(RoadGraph* graph)
-        : roadGraph(graph) {
-    LOGI("OSMParser created");
-}
-
-bool OSMParser::parseOSMFile(const std::string& filePath) {
-    LOGI("Parsing OSM file: %s using pugixml", filePath.c_str());
+namespace {
 
-    std::ifstream file(filePath);
-    if (!file.good()) {
+// Maps the file read-only and hands it to `parse`. The pages are file-backed and read front
+// to back, so the kernel can drop them behind the reader instead of holding a heap copy.
+template <typename Parse>
+bool parseMappedFile(const std::string& filePath, Parse parse) {
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
         LOGE("OSM file not found: %s", filePath.c_str());
         return false;
     }
 
-    int nodeCount = 0;
-    int wayCount = 0;
-    int roadCount = 0;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        LOGE("OSM file is empty or unreadable: %s", filePath.c_str());
+        close(fd);
+        return false;
+    }
 
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(filePath.c_str());
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
 
-    if (!result) {
-        LOGE("Failed to parse OSM file: %s", result.description());
+    if (mapping == MAP_FAILED) {
+        LOGE("Failed to map OSM file: %s", filePath.c_str());
         return false;
     }
 
-    LOGI("Processing nodes...");
-    for (pugi::xml_node node : doc.child("osm").children("node")) {
+    madvise(mapping, size, MADV_SEQUENTIAL);
 
-        long long id = node.attribute("id").as_llong();
-        double lat = node.attribute("lat").as_double();
-        double lon = node.attribute("lon").as_double();
+    bool success = parse(static_cast<const char*>(mapping), size);
 
-        Node* graphNode = roadGraph->addNode(std::to_string(id), lat, lon);
-        osmNodeMap[id] = graphNode;
+    munmap(mapping, size);
+    return success;
+}
 
-        nodeCount++;
+bool parseInt64(std::string_view text, int64_t& value) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
 
-        if (nodeCount % 10000 == 0) {
-            LOGI("Processed %d nodes", nodeCount);
-        }
+bool parseDouble(std::string_view text, double& value) {
+    char buffer[64];
+    if (text.empty() || text.size() >= sizeof(buffer)) {
+        return false;
     }
+    memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    char* end = nullptr;
+    value = strtod(buffer, &end);
+    return end == buffer + text.size();
+}
 
-    LOGI("Processing ways...");
-    for (pugi::xml_node way : doc.child("osm").children("way")) {
+bool keepsNode(const std::vector<int64_t>& routableNodes, int64_t id) {
+    return std::binary_search(routableNodes.begin(), routableNodes.end(), id);
+}
 
-        long long id = way.attribute("id").as_llong();
+void sortRoutableNodes(std::vector<int64_t>& routableNodes) {
+    std::sort(routableNodes.begin(), routableNodes.end());
+    routableNodes.erase(std::unique(routableNodes.begin(), routableNodes.end()), routableNodes.end());
+}
 
-        bool isRoad = false;
-        std::unordered_map<std::string, std::string> tags;
+}
+
+class OSMParser::XmlHandler : public OSMXmlReader::Handler {
+public:
+    XmlHandler(OSMParser* parser, Pass pass, std::vector<int64_t>& routableNodes)
+            : parser(parser), pass(pass), routableNodes(routableNodes) {}
+
+    void startElement(std::string_view name, const std::vector<OSMXmlReader::Attribute>& attributes) override {
+        if (name == "node") {
+            if (pass == Pass::COLLECT_ROUTABLE_NODES) {
+                return;
+            }
 
-        for (pugi::xml_node tag : way.children("tag")) {
-            std::string key = tag.attribute("k").value();
-            std::string value = tag.attribute("v").value();
-            tags[key] = value;
+            int64_t id;
+            double lat;
+            double lon;
+            if (parseInt64(OSMXmlReader::findAttribute(attributes, "id"), id) &&
+                parseDouble(OSMXmlReader::findAttribute(attributes, "lat"), lat) &&
+                parseDouble(OSMXmlReader::findAttribute(attributes, "lon"), lon)) {
+                if (!keepsNode(routableNodes, id)) {
+                    skippedNodeCount++;
+                    return;
+                }
+
+                parser->roadGraph->addNode(id, lat, lon);
+                nodeCount++;
+
+                if (nodeCount % 10000 == 0) {
+                    LOGI("Processed %d nodes", nodeCount);
+                }
+            }
+        } else if (name == "way") {
+            inWay = true;
+            isRoad = false;
+            wayId = 0;
+            parseInt64(OSMXmlReader::findAttribute(attributes, "id"), wayId);
+            nodeRefs.clear();
+            tags.clear();
+        } else if (inWay && name == "nd") {
+            int64_t ref;
+            if (parseInt64(OSMXmlReader::findAttribute(attributes, "ref"), ref)) {
+                nodeRefs.push_back(ref);
+            }
+        } else if (inWay && name == "tag") {
+            std::string_view key = OSMXmlReader::findAttribute(attributes, "k");
+            tags[std::string(key)] = std::string(OSMXmlReader::findAttribute(attributes, "v"));
 
             if (key == "highway") {
                 isRoad = true;
             }
         }
+    }
+
+    void endElement(std::string_view name) override {
+        if (name != "way" || !inWay) {
+            return;
+        }
+        inWay = false;
 
         if (!isRoad) {
-            continue;
+            return;
         }
 
-        std::vector<long long> nodeRefs;
-        for (pugi::xml_node nd : way.children("nd")) {
-            long long ref = nd.attribute("ref").as_llong();
-            nodeRefs.push_back(ref);
+        if (pass == Pass::COLLECT_ROUTABLE_NODES) {
+            auto access = tags.find("access");
+            if (nodeRefs.size() >= 2 &&
+                isRoutableWay(tags["highway"], access != tags.end() ? access->second : std::string())) {
+                routableNodes.insert(routableNodes.end(), nodeRefs.begin(), nodeRefs.end());
+            }
+            return;
         }
 
-        processWay(id, nodeRefs, tags);
+        parser->processWay(wayId, nodeRefs, tags);
 
         roadCount++;
         wayCount++;
@@ -102,16 +171,197 @@ bool OSMParser::parseOSMFile(const std::string& filePath) {
         }
     }
 
-    LOGI("OSM parsing completed. Nodes: %d, Ways: %d, Roads: %d",
-         nodeCount, wayCount, roadCount);
+    int nodeCount = 0;
+    int skippedNodeCount = 0;
+    int wayCount = 0;
+    int roadCount = 0;
+
+private:
+    OSMParser* parser;
+    Pass pass;
+    std::vector<int64_t>& routableNodes;
+
+    bool inWay = false;
+    bool isRoad = false;
+    int64_t wayId = 0;
+    std::vector<int64_t> nodeRefs;
+    std::unordered_map<std::string, std::string> tags;
+};
+
+class OSMParser::PbfHandler : public OSMPbfReader::Handler {
+public:
+    PbfHandler(OSMParser* parser, Pass pass, std::vector<int64_t>& routableNodes)
+            : parser(parser), pass(pass), routableNodes(routableNodes) {}
+
+    bool wantsNodes() const override { return pass != Pass::COLLECT_ROUTABLE_NODES; }
+
+    void node(int64_t id, double lat, double lon) override {
+        if (!keepsNode(routableNodes, id)) {
+            skippedNodeCount++;
+            return;
+        }
+
+        parser->roadGraph->addNode(id, lat, lon);
+        nodeCount++;
+
+        if (nodeCount % 100000 == 0) {
+            LOGI("Processed %d nodes", nodeCount);
+        }
+    }
+
+    void way(int64_t id, const std::vector<int64_t>& refs, const std::vector<OSMPbfReader::Tag>& wayTags) override {
+        bool isRoad = false;
+        std::string_view highway;
+        std::string_view access;
+        for (const OSMPbfReader::Tag& tag : wayTags) {
+            if (tag.key == "highway") {
+                isRoad = true;
+                highway = tag.value;
+            } else if (tag.key == "access") {
+                access = tag.value;
+            }
+        }
+
+        if (!isRoad) {
+            return;
+        }
+
+        if (pass == Pass::COLLECT_ROUTABLE_NODES) {
+            if (refs.size() >= 2 && isRoutableWay(highway, access)) {
+                routableNodes.insert(routableNodes.end(), refs.begin(), refs.end());
+            }
+            return;
+        }
 
-    return (nodeCount > 0 && roadCount > 0);
+        tags.clear();
+        for (const OSMPbfReader::Tag& tag : wayTags) {
+            tags[std::string(tag.key)] = std::string(tag.value);
+        }
+
+        parser->processWay(id, refs, tags);
+
+        roadCount++;
+        wayCount++;
+
+        if (wayCount % 10000 == 0) {
+            LOGI("Processed %d ways (roads: %d)", wayCount, roadCount);
+        }
+    }
+
+    int nodeCount = 0;
+    int skippedNodeCount = 0;
+    int wayCount = 0;
+    int roadCount = 0;
+
+private:
+    OSMParser* parser;
+    Pass pass;
+    std::vector<int64_t>& routableNodes;
+
+    std::unordered_map<std::string, std::string> tags;
+};
+
+OSMParser::OSMParser(RoadGraph* graph, size_t threadCount)
+        : roadGraph(graph),
+          threadCount(threadCount) {
+    LOGI("OSMParser created");
+}
+
+bool OSMParser::parseOSMFile(const std::string& filePath) {
+    LOGI("Parsing OSM file: %s", filePath.c_str());
+
+    return parseMappedFile(filePath, [this](const char* data, size_t size) {
+        return parseOSMBuffer(data, size);
+    });
+}
+
+bool OSMParser::parseOSMBuffer(const char* data, size_t size) {
+    LOGI("Parsing OSM buffer of %zu bytes", size);
+
+    if (!data || size == 0) {
+        LOGE("OSM buffer is empty");
+        return false;
+    }
+
+    if (OSMPbfReader::isPbf(data, size)) {
+        return parseOSMPBFBuffer(data, size);
+    }
+
+    OSMXmlReader reader;
+    std::vector<int64_t> routableNodes;
+
+    XmlHandler collector(this, Pass::COLLECT_ROUTABLE_NODES, routableNodes);
+    if (!reader.parse(data, size, collector)) {
+        LOGE("Failed to parse OSM data: %s", reader.getError().c_str());
+        return false;
+    }
+    sortRoutableNodes(routableNodes);
+    LOGI("Found %zu nodes on routable ways", routableNodes.size());
+
+    XmlHandler handler(this, Pass::BUILD, routableNodes);
+
+    if (!reader.parse(data, size, handler)) {
+        LOGE("Failed to parse OSM data: %s", reader.getError().c_str());
+        return false;
+    }
+
+    LOGI("OSM parsing completed. Nodes: %d (skipped %d), Ways: %d, Roads: %d",
+         handler.nodeCount, handler.skippedNodeCount, handler.wayCount, handler.roadCount);
+
+    return (handler.nodeCount > 0 && handler.roadCount > 0);
 }
 
 bool OSMParser::parseOSMPBF(const std::string& filePath) {
-    LOGI("PBF parsing not implemented - using XML parser instead");
+    LOGI("Parsing OSM PBF file: %s", filePath.c_str());
 
-    return parseOSMFile(filePath);
+    return parseMappedFile(filePath, [this](const char* data, size_t size) {
+        return parseOSMPBFBuffer(data, size);
+    });
+}
+
+bool OSMParser::parseOSMPBFBuffer(const char* data, size_t size) {
+    LOGI("Parsing OSM PBF buffer of %zu bytes", size);
+
+    OSMPbfReader reader;
+    std::vector<int64_t> routableNodes;
+
+    size_t workers = threadCount > 0 ? threadCount : ThreadPool::defaultThreadCount();
+    std::unique_ptr<ThreadPool> pool;
+    if (workers > 1) {
+        pool = std::make_unique<ThreadPool>(workers);
+    }
+
+    PbfHandler collector(this, Pass::COLLECT_ROUTABLE_NODES, routableNodes);
+    if (!reader.parse(data, size, collector, pool.get())) {
+        LOGE("Failed to parse OSM PBF data: %s", reader.getError().c_str());
+        return false;
+    }
+    sortRoutableNodes(routableNodes);
+    LOGI("Found %zu nodes on routable ways", routableNodes.size());
+
+    PbfHandler handler(this, Pass::BUILD, routableNodes);
+
+    if (!reader.parse(data, size, handler, pool.get())) {
+        LOGE("Failed to parse OSM PBF data: %s", reader.getError().c_str());
+        return false;
+    }
+
+    LOGI("OSM PBF parsing completed. Nodes: %d (skipped %d), Ways: %d, Roads: %d",
+         handler.nodeCount, handler.skippedNodeCount, handler.wayCount, handler.roadCount);
+
+    return (handler.nodeCount > 0 && handler.roadCount > 0);
+}
+
+bool OSMParser::isRoutableWay(std::string_view highway, std::string_view access) {
+    if (highway == "footway" || highway == "cycleway" ||
+        highway == "path" || highway == "steps" ||
+        highway == "pedestrian" || highway == "track" ||
+        highway == "bus_guideway" || highway == "escape" ||
+        highway == "raceway" || highway == "bridleway") {
+        return false;
+    }
+
+    return access != "private" && access != "no";
 }
 
 RoadType OSMParser::getRoadTypeFromTags(
@@ -172,8 +422,8 @@ double OSMParser::getSpeedLimitFromTags(
 }
 
 void OSMParser::processWay(
-        long long wayId,
-        const std::vector<long long>& nodeRefs,
+        int64_t wayId,
+        const std::vector<int64_t>& nodeRefs,
         const std::unordered_map<std::string, std::string>& tags) {
 
     if (nodeRefs.size() < 2) {
@@ -186,26 +436,15 @@ void OSMParser::processWay(
     }
 
     const std::string& highwayType = highway->second;
-    if (highwayType == "footway" || highwayType == "cycleway" ||
-        highwayType == "path" || highwayType == "steps" ||
-        highwayType == "pedestrian" || highwayType == "track" ||
-        highwayType == "bus_guideway" || highwayType == "escape" ||
-        highwayType == "raceway" || highwayType == "bridleway") {
-        return;
-    }
-
     auto access = tags.find("access");
-    if (access != tags.end()) {
-        const std::string& accessValue = access->second;
-        if (accessValue == "private" || accessValue == "no") {
-            return;
-        }
+    if (!isRoutableWay(highwayType, access != tags.end() ? std::string_view(access->second) : std::string_view())) {
+        return;
     }
 
     RoadType roadType = getRoadTypeFromTags(tags);
     double speedLimit = getSpeedLimitFromTags(tags, roadType);
 
-    std::string name = "Unnamed Road";
+    std::string name(RoadGraph::UNNAMED_ROAD);
     auto nameTag = tags.find("name");
     if (nameTag != tags.end()) {
         name = nameTag->second;
@@ -229,17 +468,15 @@ void OSMParser::processWay(
     }
 
     for (size_t i = 0; i < nodeRefs.size() - 1; i++) {
-        long long fromId = nodeRefs[i];
-        long long toId = nodeRefs[i + 1];
+        int64_t fromId = nodeRefs[i];
+        int64_t toId = nodeRefs[i + 1];
 
-        if (osmNodeMap.find(fromId) == osmNodeMap.end() ||
-            osmNodeMap.find(toId) == osmNodeMap.end()) {
+        Node* fromNode = roadGraph->getNode(fromId);
+        Node* toNode = roadGraph->getNode(toId);
+        if (!fromNode || !toNode) {
             continue;
         }
 
-        Node* fromNode = osmNodeMap[fromId];
-        Node* toNode = osmNodeMap[toId];
-
         RoadSegment* segment = roadGraph->addSegment(fromNode, toNode, name, speedLimit, roadType);
         segment->isOneway = isOneway;
 
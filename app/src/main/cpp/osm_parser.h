@@ -8,26 +8,42 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include "road_graph.h"
 
 class OSMParser {
 public:
-    OSMParser(RoadGraph* graph);
+    // PBF blocks are decoded on `threadCount` workers; 0 uses one per hardware thread.
+    explicit OSMParser(RoadGraph* graph, size_t threadCount = 0);
 
     bool parseOSMFile(const std::string& filePath);
 
+    bool parseOSMBuffer(const char* data, size_t size);
+
     bool parseOSMPBF(const std::string& filePath);
 
+    bool parseOSMPBFBuffer(const char* data, size_t size);
+
 private:
+    // Ways are scanned first so that only nodes referenced by routable highways are materialized.
+    enum class Pass {
+        COLLECT_ROUTABLE_NODES,
+        BUILD
+    };
+
+    class XmlHandler;
+    class PbfHandler;
+
     RoadGraph* roadGraph;
+    size_t threadCount;
 
-    std::unordered_map<long long, Node*> osmNodeMap;
+    static bool isRoutableWay(std::string_view highway, std::string_view access);
 
     void processWay(
-            long long wayId,
-            const std::vector<long long>& nodeRefs,
+            int64_t wayId,
+            const std::vector<int64_t>& nodeRefs,
             const std::unordered_map<std::string, std::string>& tags
     );
 
@@ -0,0 +1,555 @@
+/*
+ * File: osm_pbf_reader.cpp
+ * Description: Implementation of the OSMPbfReader class, responsible for decoding OSM PBF file blocks without an external protobuf runtime.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "osm_pbf_reader.h"
+#include "thread_pool.h"
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+constexpr size_t MAX_BLOB_HEADER_SIZE = 64 * 1024;
+constexpr size_t MAX_BLOB_SIZE = 32 * 1024 * 1024;
+
+int64_t zigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Minimal protobuf wire-format reader; only what the OSM PBF schema needs.
+class ProtoReader {
+public:
+    ProtoReader(const uint8_t* data, size_t size)
+            : p(data), end(data + size) {}
+
+    explicit ProtoReader(std::string_view bytes)
+            : ProtoReader(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size()) {}
+
+    bool next() {
+        if (failed || p >= end) {
+            return false;
+        }
+        uint64_t key = varint();
+        field = static_cast<uint32_t>(key >> 3);
+        wireType = static_cast<uint32_t>(key & 7);
+        return !failed;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) {
+                break;
+            }
+            uint8_t byte = *p++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        return zigzag(varint());
+    }
+
+    std::string_view bytes() {
+        uint64_t length = varint();
+        if (failed || length > static_cast<uint64_t>(end - p)) {
+            failed = true;
+            return {};
+        }
+        std::string_view result(reinterpret_cast<const char*>(p), static_cast<size_t>(length));
+        p += length;
+        return result;
+    }
+
+    // Repeated scalars are normally packed, but a proto2 writer may also emit them one by one.
+    template <typename Visitor>
+    void repeatedVarint(Visitor visit) {
+        if (wireType == 0) {
+            visit(varint());
+            return;
+        }
+        if (wireType != 2) {
+            failed = true;
+            return;
+        }
+        ProtoReader packed(bytes());
+        while (!failed && packed.p < packed.end) {
+            visit(packed.varint());
+        }
+        failed = failed || packed.failed;
+    }
+
+    void skip() {
+        switch (wireType) {
+            case 0:
+                varint();
+                break;
+            case 1:
+                advance(8);
+                break;
+            case 2:
+                bytes();
+                break;
+            case 5:
+                advance(4);
+                break;
+            default:
+                failed = true;
+                break;
+        }
+    }
+
+    bool ok() const { return !failed; }
+
+    uint32_t field = 0;
+    uint32_t wireType = 0;
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    bool failed = false;
+
+    void advance(size_t count) {
+        if (count > static_cast<size_t>(end - p)) {
+            failed = true;
+            return;
+        }
+        p += count;
+    }
+};
+
+uint32_t readBigEndian32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+}
+
+bool OSMPbfReader::isPbf(const char* data, size_t size) {
+    static const char HEADER_TYPE[] = "OSMHeader";
+    const size_t typeLength = sizeof(HEADER_TYPE) - 1;
+
+    // First BlobHeader: 4-byte length, then field 1 (type) as a short length-delimited string.
+    return size >= 6 + typeLength &&
+           static_cast<uint8_t>(data[4]) == 0x0A &&
+           static_cast<uint8_t>(data[5]) == typeLength &&
+           memcmp(data + 6, HEADER_TYPE, typeLength) == 0;
+}
+
+bool OSMPbfReader::parse(const char* data, size_t size, Handler& handler, ThreadPool* pool) {
+    error.clear();
+
+    if (!isPbf(data, size)) {
+        error = "Input does not start with an OSMHeader block";
+        return false;
+    }
+
+    std::vector<BlobRef> blobs;
+    if (!scanBlobs(data, size, blobs)) {
+        return false;
+    }
+
+    std::vector<BlobRef> dataBlobs;
+    dataBlobs.reserve(blobs.size());
+    for (const BlobRef& blob : blobs) {
+        if (!blob.isHeader) {
+            dataBlobs.push_back(blob);
+            continue;
+        }
+
+        std::string payload;
+        std::string_view content;
+        if (!inflateBlob(blob, payload, content, error) || !checkHeader(content, error)) {
+            return false;
+        }
+    }
+
+    if (pool && pool->size() > 1 && dataBlobs.size() > 1) {
+        return decodeParallel(dataBlobs, handler, *pool);
+    }
+
+    Block block;
+    for (const BlobRef& blob : dataBlobs) {
+        if (!decodeBlock(blob, handler.wantsNodes(), block, error)) {
+            return false;
+        }
+        deliver(block, handler);
+    }
+
+    return true;
+}
+
+bool OSMPbfReader::decodeParallel(const std::vector<BlobRef>& blobs, Handler& handler, ThreadPool& pool) {
+    // A bounded window of slots keeps at most a few decoded blocks per worker in memory.
+    const size_t window = pool.size() * 2;
+    std::vector<Block> blocks(window);
+    std::vector<std::string> errors(window);
+    std::vector<std::future<bool>> pending(window);
+    bool includeNodes = handler.wantsNodes();
+
+    size_t submitted = 0;
+    size_t delivered = 0;
+    bool success = true;
+
+    while (delivered < blobs.size()) {
+        while (success && submitted < blobs.size() && submitted - delivered < window) {
+            size_t slot = submitted % window;
+            const BlobRef* blob = &blobs[submitted];
+            Block* block = &blocks[slot];
+            std::string* slotError = &errors[slot];
+            pending[slot] = pool.submit([blob, includeNodes, block, slotError]() {
+                return decodeBlock(*blob, includeNodes, *block, *slotError);
+            });
+            submitted++;
+        }
+
+        if (delivered == submitted) {
+            break;
+        }
+
+        size_t slot = delivered % window;
+        bool decoded = pending[slot].get();
+        delivered++;
+
+        if (!success) {
+            continue;
+        }
+        if (!decoded) {
+            error = errors[slot];
+            success = false;
+            continue;
+        }
+        deliver(blocks[slot], handler);
+    }
+
+    return success;
+}
+
+bool OSMPbfReader::scanBlobs(const char* data, size_t size, std::vector<BlobRef>& blobs) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+
+    while (p < end) {
+        if (end - p < 4) {
+            error = "Truncated blob header length";
+            return false;
+        }
+        uint32_t headerSize = readBigEndian32(p);
+        p += 4;
+
+        if (headerSize > MAX_BLOB_HEADER_SIZE || headerSize > static_cast<size_t>(end - p)) {
+            error = "Invalid blob header size";
+            return false;
+        }
+
+        ProtoReader header(p, headerSize);
+        std::string_view type;
+        uint64_t dataSize = 0;
+        bool hasDataSize = false;
+
+        while (header.next()) {
+            if (header.field == 1 && header.wireType == 2) {
+                type = header.bytes();
+            } else if (header.field == 3 && header.wireType == 0) {
+                dataSize = header.varint();
+                hasDataSize = true;
+            } else {
+                header.skip();
+            }
+        }
+        p += headerSize;
+
+        if (!header.ok() || !hasDataSize) {
+            error = "Malformed blob header";
+            return false;
+        }
+        if (dataSize > MAX_BLOB_SIZE || dataSize > static_cast<uint64_t>(end - p)) {
+            error = "Invalid blob size";
+            return false;
+        }
+
+        // Unknown blob types are skipped, as the format requires.
+        if (type == "OSMHeader" || type == "OSMData") {
+            blobs.push_back({p, static_cast<size_t>(dataSize), type == "OSMHeader"});
+        }
+        p += dataSize;
+    }
+
+    if (blobs.empty() || !blobs.front().isHeader) {
+        error = "Missing OSMHeader block";
+        return false;
+    }
+
+    return true;
+}
+
+bool OSMPbfReader::inflateBlob(const BlobRef& blob, std::string& payload, std::string_view& content,
+                               std::string& error) {
+    ProtoReader reader(blob.data, blob.size);
+    std::string_view raw;
+    std::string_view compressed;
+    uint64_t rawSize = 0;
+    bool hasRaw = false;
+    bool hasCompressed = false;
+
+    while (reader.next()) {
+        if (reader.field == 1 && reader.wireType == 2) {
+            raw = reader.bytes();
+            hasRaw = true;
+        } else if (reader.field == 2 && reader.wireType == 0) {
+            rawSize = reader.varint();
+        } else if (reader.field == 3 && reader.wireType == 2) {
+            compressed = reader.bytes();
+            hasCompressed = true;
+        } else if (reader.field >= 4 && reader.field <= 7) {
+            error = "Unsupported blob compression (only raw and zlib are supported)";
+            return false;
+        } else {
+            reader.skip();
+        }
+    }
+
+    if (!reader.ok()) {
+        error = "Malformed blob";
+        return false;
+    }
+
+    if (hasRaw) {
+        content = raw;
+        return true;
+    }
+
+    if (!hasCompressed || rawSize > MAX_BLOB_SIZE) {
+        error = "Blob has no usable payload";
+        return false;
+    }
+
+    payload.resize(static_cast<size_t>(rawSize));
+    uLongf inflatedSize = static_cast<uLongf>(rawSize);
+    int status = uncompress(reinterpret_cast<Bytef*>(&payload[0]), &inflatedSize,
+                            reinterpret_cast<const Bytef*>(compressed.data()),
+                            static_cast<uLong>(compressed.size()));
+
+    if (status != Z_OK || inflatedSize != rawSize) {
+        error = "Failed to inflate zlib blob";
+        return false;
+    }
+
+    content = std::string_view(payload.data(), payload.size());
+    return true;
+}
+
+bool OSMPbfReader::checkHeader(std::string_view content, std::string& error) {
+    ProtoReader reader(content);
+
+    while (reader.next()) {
+        if (reader.field == 4 && reader.wireType == 2) {
+            std::string_view feature = reader.bytes();
+            if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+                error = "Unsupported required feature: " + std::string(feature);
+                return false;
+            }
+        } else {
+            reader.skip();
+        }
+    }
+
+    if (!reader.ok()) {
+        error = "Malformed OSMHeader block";
+        return false;
+    }
+    return true;
+}
+
+bool OSMPbfReader::decodeBlock(const BlobRef& blob, bool includeNodes, Block& block, std::string& error) {
+    block.strings.clear();
+    block.nodes.clear();
+    block.ways.clear();
+    block.refs.clear();
+    block.tagKeys.clear();
+    block.tagValues.clear();
+
+    std::string_view content;
+    if (!inflateBlob(blob, block.payload, content, error)) {
+        return false;
+    }
+
+    ProtoReader reader(content);
+    std::vector<std::string_view> groups;
+    int64_t granularity = 100;
+    int64_t latOffset = 0;
+    int64_t lonOffset = 0;
+
+    while (reader.next()) {
+        if (reader.field == 1 && reader.wireType == 2) {
+            ProtoReader table(reader.bytes());
+            while (table.next()) {
+                if (table.field == 1 && table.wireType == 2) {
+                    block.strings.push_back(table.bytes());
+                } else {
+                    table.skip();
+                }
+            }
+            if (!table.ok()) {
+                error = "Malformed string table";
+                return false;
+            }
+        } else if (reader.field == 2 && reader.wireType == 2) {
+            groups.push_back(reader.bytes());
+        } else if (reader.field == 17 && reader.wireType == 0) {
+            granularity = static_cast<int32_t>(reader.varint());
+        } else if (reader.field == 19 && reader.wireType == 0) {
+            latOffset = static_cast<int64_t>(reader.varint());
+        } else if (reader.field == 20 && reader.wireType == 0) {
+            lonOffset = static_cast<int64_t>(reader.varint());
+        } else {
+            reader.skip();
+        }
+    }
+
+    if (!reader.ok()) {
+        error = "Malformed primitive block";
+        return false;
+    }
+
+    auto toDegrees = [granularity](int64_t offset, int64_t value) {
+        return 1e-9 * static_cast<double>(offset + granularity * value);
+    };
+
+    std::vector<int64_t> denseIds;
+    std::vector<int64_t> denseLats;
+    std::vector<int64_t> denseLons;
+
+    for (std::string_view groupData : groups) {
+        ProtoReader group(groupData);
+
+        while (group.next()) {
+            if (!includeNodes && (group.field == 1 || group.field == 2)) {
+                group.skip();
+            } else if (group.field == 1 && group.wireType == 2) {
+                ProtoReader node(group.bytes());
+                int64_t id = 0;
+                int64_t lat = 0;
+                int64_t lon = 0;
+                while (node.next()) {
+                    if (node.field == 1 && node.wireType == 0) {
+                        id = node.signedVarint();
+                    } else if (node.field == 8 && node.wireType == 0) {
+                        lat = node.signedVarint();
+                    } else if (node.field == 9 && node.wireType == 0) {
+                        lon = node.signedVarint();
+                    } else {
+                        node.skip();
+                    }
+                }
+                if (!node.ok()) {
+                    error = "Malformed node";
+                    return false;
+                }
+                block.nodes.push_back({id, toDegrees(latOffset, lat), toDegrees(lonOffset, lon)});
+            } else if (group.field == 2 && group.wireType == 2) {
+                ProtoReader dense(group.bytes());
+                denseIds.clear();
+                denseLats.clear();
+                denseLons.clear();
+
+                while (dense.next()) {
+                    if (dense.field == 1) {
+                        dense.repeatedVarint([&](uint64_t v) { denseIds.push_back(zigzag(v)); });
+                    } else if (dense.field == 8) {
+                        dense.repeatedVarint([&](uint64_t v) { denseLats.push_back(zigzag(v)); });
+                    } else if (dense.field == 9) {
+                        dense.repeatedVarint([&](uint64_t v) { denseLons.push_back(zigzag(v)); });
+                    } else {
+                        dense.skip();
+                    }
+                }
+                if (!dense.ok() || denseIds.size() != denseLats.size() || denseIds.size() != denseLons.size()) {
+                    error = "Malformed dense nodes";
+                    return false;
+                }
+
+                int64_t id = 0;
+                int64_t lat = 0;
+                int64_t lon = 0;
+                for (size_t i = 0; i < denseIds.size(); i++) {
+                    id += denseIds[i];
+                    lat += denseLats[i];
+                    lon += denseLons[i];
+                    block.nodes.push_back({id, toDegrees(latOffset, lat), toDegrees(lonOffset, lon)});
+                }
+            } else if (group.field == 3 && group.wireType == 2) {
+                ProtoReader way(group.bytes());
+                WayRecord record{0, static_cast<uint32_t>(block.refs.size()), 0,
+                                 static_cast<uint32_t>(block.tagKeys.size()), 0};
+                int64_t ref = 0;
+
+                while (way.next()) {
+                    if (way.field == 1 && way.wireType == 0) {
+                        record.id = static_cast<int64_t>(way.varint());
+                    } else if (way.field == 2) {
+                        way.repeatedVarint([&](uint64_t v) { block.tagKeys.push_back(static_cast<uint32_t>(v)); });
+                    } else if (way.field == 3) {
+                        way.repeatedVarint([&](uint64_t v) { block.tagValues.push_back(static_cast<uint32_t>(v)); });
+                    } else if (way.field == 8) {
+                        way.repeatedVarint([&](uint64_t v) {
+                            ref += zigzag(v);
+                            block.refs.push_back(ref);
+                        });
+                    } else {
+                        way.skip();
+                    }
+                }
+                if (!way.ok() || block.tagKeys.size() != block.tagValues.size()) {
+                    error = "Malformed way";
+                    return false;
+                }
+
+                record.refCount = static_cast<uint32_t>(block.refs.size()) - record.firstRef;
+                record.tagCount = static_cast<uint32_t>(block.tagKeys.size()) - record.firstTag;
+                for (uint32_t i = record.firstTag; i < record.firstTag + record.tagCount; i++) {
+                    if (block.tagKeys[i] >= block.strings.size() || block.tagValues[i] >= block.strings.size()) {
+                        error = "Way tag refers outside the string table";
+                        return false;
+                    }
+                }
+                block.ways.push_back(record);
+            } else {
+                group.skip();
+            }
+        }
+
+        if (!group.ok()) {
+            error = "Malformed primitive group";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void OSMPbfReader::deliver(const Block& block, Handler& handler) {
+    for (const NodeRecord& node : block.nodes) {
+        handler.node(node.id, node.lat, node.lon);
+    }
+
+    for (const WayRecord& way : block.ways) {
+        wayRefs.assign(block.refs.begin() + way.firstRef,
+                       block.refs.begin() + way.firstRef + way.refCount);
+
+        wayTags.clear();
+        for (uint32_t i = way.firstTag; i < way.firstTag + way.tagCount; i++) {
+            wayTags.push_back({block.strings[block.tagKeys[i]], block.strings[block.tagValues[i]]});
+        }
+
+        handler.way(way.id, wayRefs, wayTags);
+    }
+}
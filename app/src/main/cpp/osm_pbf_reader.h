@@ -0,0 +1,90 @@
+/*
+ * File: osm_pbf_reader.h
+ * Description: Header file for the OSMPbfReader class, a decoder for OSM PBF extracts (zlib blobs, dense nodes, delta-coded ways).
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ThreadPool;
+
+class OSMPbfReader {
+public:
+    struct Tag {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    // Views passed to the handler are only valid for the duration of the callback.
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        // Node groups are not decoded at all when the handler only needs ways.
+        virtual bool wantsNodes() const { return true; }
+
+        virtual void node(int64_t id, double lat, double lon) = 0;
+        virtual void way(int64_t id, const std::vector<int64_t>& refs, const std::vector<Tag>& tags) = 0;
+    };
+
+    OSMPbfReader() = default;
+
+    // With a pool, blobs are decoded concurrently but still delivered to the handler in file order.
+    bool parse(const char* data, size_t size, Handler& handler, ThreadPool* pool = nullptr);
+
+    const std::string& getError() const { return error; }
+
+    static bool isPbf(const char* data, size_t size);
+
+private:
+    struct BlobRef {
+        const uint8_t* data;
+        size_t size;
+        bool isHeader;
+    };
+
+    struct NodeRecord {
+        int64_t id;
+        double lat;
+        double lon;
+    };
+
+    struct WayRecord {
+        int64_t id;
+        uint32_t firstRef;
+        uint32_t refCount;
+        uint32_t firstTag;
+        uint32_t tagCount;
+    };
+
+    // One decoded OSMData blob; string views point into `payload` or into the input buffer.
+    struct Block {
+        std::string payload;
+        std::vector<std::string_view> strings;
+        std::vector<NodeRecord> nodes;
+        std::vector<WayRecord> ways;
+        std::vector<int64_t> refs;
+        std::vector<uint32_t> tagKeys;
+        std::vector<uint32_t> tagValues;
+    };
+
+    std::vector<int64_t> wayRefs;
+    std::vector<Tag> wayTags;
+    std::string error;
+
+    bool scanBlobs(const char* data, size_t size, std::vector<BlobRef>& blobs);
+    bool decodeParallel(const std::vector<BlobRef>& blobs, Handler& handler, ThreadPool& pool);
+
+    static bool inflateBlob(const BlobRef& blob, std::string& payload, std::string_view& content, std::string& error);
+    static bool checkHeader(std::string_view content, std::string& error);
+    static bool decodeBlock(const BlobRef& blob, bool includeNodes, Block& block, std::string& error);
+
+    void deliver(const Block& block, Handler& handler);
+};
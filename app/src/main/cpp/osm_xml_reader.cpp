@@ -0,0 +1,301 @@
+/*
+ * File: osm_xml_reader.cpp
+ * Description: Implementation of the OSMXmlReader class, responsible for scanning XML elements and attributes without building a document tree.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "osm_xml_reader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isNameEnd(char c) {
+    return isSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* skipName(const char* p, const char* end) {
+    while (p < end && !isNameEnd(*p)) {
+        p++;
+    }
+    return p;
+}
+
+const char* findSequence(const char* p, const char* end, const char* sequence) {
+    size_t length = strlen(sequence);
+    while (static_cast<size_t>(end - p) >= length) {
+        const char* candidate = static_cast<const char*>(memchr(p, sequence[0], end - p));
+        if (!candidate || static_cast<size_t>(end - candidate) < length) {
+            return nullptr;
+        }
+        if (memcmp(candidate, sequence, length) == 0) {
+            return candidate;
+        }
+        p = candidate + 1;
+    }
+    return nullptr;
+}
+
+bool startsWith(const char* p, const char* end, const char* prefix) {
+    size_t length = strlen(prefix);
+    return static_cast<size_t>(end - p) >= length && memcmp(p, prefix, length) == 0;
+}
+
+}
+
+bool OSMXmlReader::parse(const char* data, size_t size, Handler& handler) {
+    error.clear();
+    openElements.clear();
+
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p < end) {
+        p = static_cast<const char*>(memchr(p, '<', end - p));
+        if (!p) {
+            break;
+        }
+        const char* tagStart = p;
+        p++;
+
+        if (startsWith(p, end, "?")) {
+            const char* close = findSequence(p, end, "?>");
+            if (!close) {
+                return fail("Unterminated processing instruction", data, tagStart);
+            }
+            p = close + 2;
+            continue;
+        }
+
+        if (startsWith(p, end, "!--")) {
+            const char* close = findSequence(p + 3, end, "-->");
+            if (!close) {
+                return fail("Unterminated comment", data, tagStart);
+            }
+            p = close + 3;
+            continue;
+        }
+
+        if (startsWith(p, end, "![CDATA[")) {
+            const char* close = findSequence(p + 8, end, "]]>");
+            if (!close) {
+                return fail("Unterminated CDATA section", data, tagStart);
+            }
+            p = close + 3;
+            continue;
+        }
+
+        if (startsWith(p, end, "!")) {
+            const char* close = static_cast<const char*>(memchr(p, '>', end - p));
+            if (!close) {
+                return fail("Unterminated declaration", data, tagStart);
+            }
+            p = close + 1;
+            continue;
+        }
+
+        if (startsWith(p, end, "/")) {
+            const char* nameStart = p + 1;
+            const char* nameEnd = skipName(nameStart, end);
+            std::string_view name(nameStart, nameEnd - nameStart);
+
+            p = skipSpace(nameEnd, end);
+            if (p >= end || *p != '>') {
+                return fail("Malformed end tag", data, tagStart);
+            }
+            p++;
+
+            if (openElements.empty() || openElements.back() != name) {
+                return fail("Mismatched end tag", data, tagStart);
+            }
+            openElements.pop_back();
+            handler.endElement(name);
+            continue;
+        }
+
+        const char* nameEnd = skipName(p, end);
+        if (nameEnd == p) {
+            return fail("Missing element name", data, tagStart);
+        }
+        std::string_view name(p, nameEnd - p);
+        p = nameEnd;
+
+        attributes.clear();
+        bool hasEntities = false;
+        bool selfClosing = false;
+
+        while (true) {
+            p = skipSpace(p, end);
+            if (p >= end) {
+                return fail("Unterminated start tag", data, tagStart);
+            }
+            if (*p == '>') {
+                p++;
+                break;
+            }
+            if (*p == '/') {
+                if (p + 1 >= end || p[1] != '>') {
+                    return fail("Malformed empty element", data, tagStart);
+                }
+                selfClosing = true;
+                p += 2;
+                break;
+            }
+
+            const char* attributeEnd = skipName(p, end);
+            if (attributeEnd == p) {
+                return fail("Missing attribute name", data, tagStart);
+            }
+            std::string_view attributeName(p, attributeEnd - p);
+
+            p = skipSpace(attributeEnd, end);
+            if (p >= end || *p != '=') {
+                return fail("Missing '=' after attribute name", data, tagStart);
+            }
+            p = skipSpace(p + 1, end);
+            if (p >= end || (*p != '"' && *p != '\'')) {
+                return fail("Missing attribute quote", data, tagStart);
+            }
+
+            char quote = *p++;
+            const char* valueEnd = static_cast<const char*>(memchr(p, quote, end - p));
+            if (!valueEnd) {
+                return fail("Unterminated attribute value", data, tagStart);
+            }
+
+            std::string_view value(p, valueEnd - p);
+            if (!hasEntities && value.find('&') != std::string_view::npos) {
+                hasEntities = true;
+            }
+            attributes.push_back({attributeName, value});
+            p = valueEnd + 1;
+        }
+
+        if (hasEntities) {
+            decodeAttributes();
+        }
+
+        handler.startElement(name, attributes);
+        if (selfClosing) {
+            handler.endElement(name);
+        } else {
+            openElements.push_back(name);
+        }
+    }
+
+    if (!openElements.empty()) {
+        return fail("Unexpected end of input", data, end);
+    }
+
+    return true;
+}
+
+std::string_view OSMXmlReader::findAttribute(const std::vector<Attribute>& attributes, std::string_view name) {
+    for (const Attribute& attribute : attributes) {
+        if (attribute.name == name) {
+            return attribute.value;
+        }
+    }
+    return {};
+}
+
+bool OSMXmlReader::fail(const char* message, const char* data, const char* position) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s at byte %zu", message, static_cast<size_t>(position - data));
+    error = buffer;
+    return false;
+}
+
+void OSMXmlReader::decodeAttributes() {
+    // Decoding never grows a value, so reserving the raw size keeps the views into `decoded` stable.
+    size_t rawSize = 0;
+    for (const Attribute& attribute : attributes) {
+        rawSize += attribute.value.size();
+    }
+    decoded.clear();
+    decoded.reserve(rawSize);
+
+    for (Attribute& attribute : attributes) {
+        if (attribute.value.find('&') == std::string_view::npos) {
+            continue;
+        }
+        size_t offset = decoded.size();
+        appendDecoded(attribute.value, decoded);
+        attribute.value = std::string_view(decoded.data() + offset, decoded.size() - offset);
+    }
+}
+
+void OSMXmlReader::appendDecoded(std::string_view raw, std::string& out) {
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t amp = raw.find('&', i);
+        if (amp == std::string_view::npos) {
+            out.append(raw.data() + i, raw.size() - i);
+            return;
+        }
+        out.append(raw.data() + i, amp - i);
+
+        size_t semicolon = raw.find(';', amp);
+        if (semicolon == std::string_view::npos) {
+            out.append(raw.data() + amp, raw.size() - amp);
+            return;
+        }
+
+        std::string_view entity = raw.substr(amp + 1, semicolon - amp - 1);
+        if (entity == "amp") {
+            out += '&';
+        } else if (entity == "lt") {
+            out += '<';
+        } else if (entity == "gt") {
+            out += '>';
+        } else if (entity == "quot") {
+            out += '"';
+        } else if (entity == "apos") {
+            out += '\'';
+        } else if (entity.size() > 1 && entity[0] == '#') {
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            std::string digits(entity.substr(hex ? 2 : 1));
+            char* digitsEnd = nullptr;
+            unsigned long codePoint = strtoul(digits.c_str(), &digitsEnd, hex ? 16 : 10);
+            if (digits.empty() || *digitsEnd != '\0' || codePoint > 0x10FFFF) {
+                out.append(raw.data() + amp, semicolon - amp + 1);
+            } else {
+                appendUtf8(codePoint, out);
+            }
+        } else {
+            out.append(raw.data() + amp, semicolon - amp + 1);
+        }
+        i = semicolon + 1;
+    }
+}
+
+void OSMXmlReader::appendUtf8(unsigned long codePoint, std::string& out) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * File: osm_xml_reader.h
+ * Description: Header file for the OSMXmlReader class, a single-pass SAX-style XML reader for OSM extracts.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class OSMXmlReader {
+public:
+    struct Attribute {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // Views passed to the handler are only valid for the duration of the callback.
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void startElement(std::string_view name, const std::vector<Attribute>& attributes) = 0;
+        virtual void endElement(std::string_view name) = 0;
+    };
+
+    OSMXmlReader() = default;
+
+    bool parse(const char* data, size_t size, Handler& handler);
+
+    const std::string& getError() const { return error; }
+
+    static std::string_view findAttribute(const std::vector<Attribute>& attributes, std::string_view name);
+
+private:
+    std::vector<Attribute> attributes;
+    std::vector<std::string_view> openElements;
+    std::string decoded;
+    std::string error;
+
+    bool fail(const char* message, const char* data, const char* position);
+
+    void decodeAttributes();
+
+    static void appendDecoded(std::string_view raw, std::string& out);
+    static void appendUtf8(unsigned long codePoint, std::string& out);
+};
@@ -0,0 +1,48 @@
+/*
+ * File: packed_array.h
+ * Description: Header file for the PackedArray template, a read-only array that either owns its values or views external memory.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+template <typename T>
+class PackedArray {
+public:
+    PackedArray() = default;
+    PackedArray(const PackedArray&) = delete;
+    PackedArray& operator=(const PackedArray&) = delete;
+    PackedArray(PackedArray&&) = default;
+    PackedArray& operator=(PackedArray&&) = default;
+
+    void assign(std::vector<T> values) {
+        owned = std::move(values);
+        first = owned.data();
+        count = owned.size();
+    }
+
+    void attach(const T* data, size_t size) {
+        owned = std::vector<T>();
+        first = data;
+        count = size;
+    }
+
+    const T& operator[](size_t index) const { return first[index]; }
+    const T& back() const { return first[count - 1]; }
+
+    const T* data() const { return first; }
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    std::vector<T> owned;
+    const T* first = nullptr;
+    size_t count = 0;
+};
@@ -7,95 +7,25 @@
 
 #include "road_graph.h"
 #include "osm_parser.h"
+#include "compact_graph.h"
+#include "segment_rtree.h"
+#include "contraction_hierarchy.h"
+#include "landmark_index.h"
+#include "graph_snapshot.h"
 #include <android/log.h>
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
-#include <queue>
-#include <unordered_set>
+#include <mutex>
 
 #define LOG_TAG "RoadGraph"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
-class SpatialIndex {
-public:
-    SpatialIndex(double cellSize = 0.001) : cellSize(cellSize) {
-        LOGI("Created SpatialIndex with cell size %.5f degrees", cellSize);
-    }
-
-    void clear() {
-        cells.clear();
-        allSegments.clear();
-        LOGI("SpatialIndex cleared");
-    }
-
-    void addSegment(RoadSegment* segment, double startLat, double startLon, double endLat, double endLon) {
-
-        double minLat = std::min(startLat, endLat);
-        double maxLat = std::max(startLat, endLat);
-        double minLon = std::min(startLon, endLon);
-        double maxLon = std::max(startLon, endLon);
-
-        int minLatCell = static_cast<int>(minLat / cellSize);
-        int maxLatCell = static_cast<int>(maxLat / cellSize);
-        int minLonCell = static_cast<int>(minLon / cellSize);
-        int maxLonCell = static_cast<int>(maxLon / cellSize);
-
-        for (int latCell = minLatCell; latCell <= maxLatCell; latCell++) {
-            for (int lonCell = minLonCell; lonCell <= maxLonCell; lonCell++) {
-                std::string cellKey = std::to_string(latCell) + "," + std::to_string(lonCell);
-                cells[cellKey].push_back(segment);
-            }
-        }
-
-        allSegments.push_back(segment);
-    }
-
-    std::vector<RoadSegment*> findNearby(double lat, double lon, double radiusMeters) {
-
-        int latCell = static_cast<int>(lat / cellSize);
-        int lonCell = static_cast<int>(lon / cellSize);
-
-        double degreesRadius = radiusMeters / 111000.0;
-        int cellRadius = std::max(1, static_cast<int>(degreesRadius / cellSize) + 1);
-
-        std::vector<RoadSegment*> result;
-        std::unordered_set<RoadSegment*> segmentSet;
-
-        for (int i = -cellRadius; i <= cellRadius; i++) {
-            for (int j = -cellRadius; j <= cellRadius; j++) {
-                std::string cellKey = std::to_string(latCell + i) + "," + std::to_string(lonCell + j);
-
-                if (cells.find(cellKey) != cells.end()) {
-                    for (RoadSegment* segment : cells[cellKey]) {
-                        segmentSet.insert(segment);
-                    }
-                }
-            }
-        }
-
-        if (segmentSet.empty() && radiusMeters > 1000.0) {
-            LOGI("No segments found in spatial index cells, returning all segments (%zu)", allSegments.size());
-            return allSegments;
-        }
-
-        result.insert(result.end(), segmentSet.begin(), segmentSet.end());
-
-        LOGD("Found %zu nearby segments in spatial index", result.size());
-        return result;
-    }
-
-private:
-    double cellSize;
-    std::unordered_map<std::string, std::vector<RoadSegment*>> cells;
-    std::vector<RoadSegment*> allSegments;
-};
-
-RoadGraph::RoadGraph() {
+RoadGraph::RoadGraph(size_t loaderThreadCount) {
     LOGI("Creating RoadGraph");
-    spatialIndex = std::make_unique<SpatialIndex>(0.001);
-    osmParser = std::make_unique<OSMParser>(this);
+    osmParser = std::make_unique<OSMParser>(this, loaderThreadCount);
 }
 
 RoadGraph::~RoadGraph() {
@@ -106,22 +36,48 @@ RoadGraph::~RoadGraph() {
 void RoadGraph::clear() {
     LOGI("Clearing RoadGraph");
     nodes.clear();
-    segments.clear();
-    spatialIndex = std::make_unique<SpatialIndex>(0.001);
+    nodeStorage.clear();
+    segmentStorage.clear();
+    compactGraph.reset();
+    segmentTree.reset();
+    hierarchy.reset();
+    landmarks.reset();
+    namePool.clear();
+    snapshotStorage.reset();
     nextSegmentId = 1;
+    nextSyntheticId = -1;
+    generation++;
 }
 
-std::vector<RoadSegment*> RoadGraph::findNearbyRoads(const Location& loc, double radius) {
-    LOGD("Searching nearby roads at (%.6f, %.6f) within %.1f meters", loc.latitude, loc.longitude, radius);
-    auto nearby = spatialIndex->findNearby(loc.latitude, loc.longitude, radius);
-    LOGD("Found %zu nearby segments", nearby.size());
+std::vector<RoadSegment*> RoadGraph::findNearbyRoads(const Location& loc, double radius) const {
+    std::vector<RoadSegment*> nearby;
+    findNearbyRoads(loc, radius, nearby);
     return nearby;
 }
 
-Node* RoadGraph::getNode(const std::string& id) {
+void RoadGraph::findNearbyRoads(const Location& loc, double radius, std::vector<RoadSegment*>& result) const {
+    LOGD("Searching nearby roads at (%.6f, %.6f) within %.1f meters", loc.latitude, loc.longitude, radius);
+    if (!segmentTree) {
+        result.clear();
+        return;
+    }
+    segmentTree->findWithinRadius(loc.latitude, loc.longitude, radius, result);
+    LOGD("Found %zu nearby segments", result.size());
+}
+
+void RoadGraph::findNearestRoads(const Location& loc, size_t count, double maxRadius,
+                                 std::vector<RoadSegment*>& result) const {
+    if (!segmentTree) {
+        result.clear();
+        return;
+    }
+    segmentTree->findNearest(loc.latitude, loc.longitude, count, maxRadius, result);
+}
+
+Node* RoadGraph::getNode(int64_t id) {
     auto it = nodes.find(id);
     if (it != nodes.end()) {
-        return it->second.get();
+        return it->second;
     }
     return nullptr;
 }
@@ -129,6 +85,7 @@ Node* RoadGraph::getNode(const std::string& id) {
 bool RoadGraph::loadOSMData(const std::string& filePath) {
     LOGI("Loading OSM data from file: %s", filePath.c_str());
 
+    std::unique_lock<std::shared_mutex> lock(graphMutex);
     clear();
 
     std::string extension;
@@ -155,28 +112,211 @@ bool RoadGraph::loadOSMData(const std::string& filePath) {
     }
 
     LOGI("Road graph contains %zu nodes and %zu segments",
-         nodes.size(), segments.size());
+         nodes.size(), segmentStorage.size());
+
+    freeze();
 
     return true;
 }
 
+bool RoadGraph::loadOSMBuffer(const char* data, size_t size) {
+    LOGI("Loading OSM data from buffer of %zu bytes", size);
+
+    std::unique_lock<std::shared_mutex> lock(graphMutex);
+    clear();
+
+    if (!osmParser->parseOSMBuffer(data, size)) {
+        LOGE("Failed to load OSM data");
+        return false;
+    }
+
+    LOGI("Road graph contains %zu nodes and %zu segments",
+         nodes.size(), segmentStorage.size());
+
+    freeze();
+
+    return true;
+}
+
+void RoadGraph::pinNode(Node* node) {
+    if (compactGraph && node) {
+        compactGraph->pin(node->index);
+    }
+}
+
+void RoadGraph::freeze() {
+    compactGraph = std::make_unique<CompactGraph>();
+    compactGraph->build(nodeStorage);
+    compactGraph->contractChains();
+
+    buildSegmentTree();
+
+    hierarchy = std::make_unique<ContractionHierarchy>();
+    hierarchy->build(*compactGraph);
+
+    landmarks = std::make_unique<LandmarkIndex>();
+    landmarks->build(*compactGraph);
+}
+
+void RoadGraph::buildSegmentTree() {
+    std::vector<RoadSegment*> allSegments;
+    allSegments.reserve(segmentStorage.size());
+    for (RoadSegment& segment : segmentStorage) {
+        allSegments.push_back(&segment);
+    }
+
+    segmentTree = std::make_unique<SegmentRTree>();
+    segmentTree->build(allSegments);
+}
+
+bool RoadGraph::saveSnapshot(const std::string& path, uint64_t sourceFingerprint) const {
+    std::shared_lock<std::shared_mutex> lock(graphMutex);
+    return GraphSnapshot::write(path, *this, sourceFingerprint);
+}
+
+bool RoadGraph::loadSnapshot(const std::string& path, uint64_t sourceFingerprint) {
+    std::shared_ptr<const GraphSnapshot> snapshot = GraphSnapshot::open(path);
+    if (!snapshot) {
+        return false;
+    }
+
+    if (sourceFingerprint != 0 && snapshot->getSourceFingerprint() != sourceFingerprint) {
+        LOGI("Graph snapshot %s is stale, ignoring it", path.c_str());
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(graphMutex);
+    clear();
+
+    size_t nodeCount = snapshot->getNodesCount();
+    size_t edgeCount = snapshot->getEdgesCount();
+    const int64_t* ids = snapshot->nodeIds();
+    const double* lat = snapshot->nodeLatitudes();
+    const double* lon = snapshot->nodeLongitudes();
+    const uint32_t* firstEdge = snapshot->firstEdge();
+    const CompactGraph::Edge* edges = snapshot->edges();
+    const uint32_t* edgeNames = snapshot->edgeNames();
+    const uint8_t* edgeFlags = snapshot->edgeFlags();
+
+    nodes.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        Node& node = nodeStorage.emplace_back();
+        node.id = ids[i];
+        node.index = static_cast<uint32_t>(i);
+        node.latitude = lat[i];
+        node.longitude = lon[i];
+        nodes.emplace(node.id, &node);
+    }
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        Node& node = nodeStorage[i];
+        node.segments.reserve(firstEdge[i + 1] - firstEdge[i]);
+
+        for (uint32_t e = firstEdge[i]; e < firstEdge[i + 1]; e++) {
+            const CompactGraph::Edge& edge = edges[e];
+            RoadSegment& segment = segmentStorage.emplace_back();
+            segment.start = &node;
+            segment.end = &nodeStorage[edge.target];
+            segment.name = snapshot->name(edgeNames[e]);
+            segment.speedLimit = edge.speedLimit;
+            segment.type = edge.type;
+            segment.length = edge.length;
+            segment.id = static_cast<int>(e) + 1;
+            segment.isOneway = (edgeFlags[e] & GraphSnapshot::EDGE_FLAG_ONEWAY) != 0;
+            node.segments.push_back(&segment);
+        }
+    }
+    nextSegmentId = static_cast<int>(edgeCount) + 1;
+
+    compactGraph = std::make_unique<CompactGraph>();
+    compactGraph->attach(lat, lon, nodeCount, firstEdge, edges, edgeCount,
+                         snapshot->chainFirst(), snapshot->chainEdges(), snapshot->getChainEdgesCount(),
+                         snapshot->chainViaFirst(), snapshot->chainViaNodes(), snapshot->chainViaDistances(),
+                         snapshot->getChainViaNodesCount(), snapshot->interiorNodes(),
+                         snapshot->reverseFirst(), snapshot->reverseEdges(), snapshot->getReverseEdgesCount(),
+                         snapshot);
+    snapshotStorage = snapshot;
+
+    if (snapshot->getTreeBoxesCount() > 0) {
+        const uint64_t* levelEnds = snapshot->treeLevelEnds();
+        std::vector<size_t> levels(levelEnds, levelEnds + snapshot->getTreeLevelsCount());
+
+        const uint32_t* treeItems = snapshot->treeItems();
+        std::vector<RoadSegment*> items(levels.front());
+        for (size_t i = 0; i < items.size(); i++) {
+            items[i] = &segmentStorage[treeItems[i]];
+        }
+
+        segmentTree = std::make_unique<SegmentRTree>();
+        segmentTree->attach(snapshot->treeBoxes(), snapshot->treeFirstChild(), snapshot->getTreeBoxesCount(),
+                            std::move(levels), std::move(items), snapshot);
+    } else {
+        buildSegmentTree();
+    }
+
+    hierarchy = std::make_unique<ContractionHierarchy>();
+    if (snapshot->getHierarchyNodesCount() == nodeCount) {
+        hierarchy->attach(snapshot->hierarchyUpFirst(), snapshot->hierarchyUpEdges(),
+                          snapshot->getHierarchyUpEdgesCount(),
+                          snapshot->hierarchyDownFirst(), snapshot->hierarchyDownEdges(),
+                          snapshot->getHierarchyDownEdgesCount(), nodeCount, snapshot);
+    } else {
+        hierarchy->build(*compactGraph);
+    }
+
+    landmarks = std::make_unique<LandmarkIndex>();
+    if (snapshot->getLandmarksCount() > 0) {
+        landmarks->attach(snapshot->landmarkNodes(), snapshot->getLandmarksCount(),
+                          snapshot->landmarkFromDistances(), snapshot->landmarkToDistances(),
+                          nodeCount, snapshot);
+    } else {
+        landmarks->build(*compactGraph);
+    }
+
+    LOGI("Loaded graph snapshot %s: %zu nodes, %zu segments", path.c_str(), nodeCount, edgeCount);
+    return true;
+}
+
+Node* RoadGraph::addNode(int64_t id, double lat, double lon) {
+    auto existing = nodes.find(id);
+    if (existing != nodes.end()) {
+        return existing->second;
+    }
+
+    Node& node = nodeStorage.emplace_back();
+    node.id = id;
+    node.index = static_cast<uint32_t>(nodeStorage.size() - 1);
+    node.latitude = lat;
+    node.longitude = lon;
+
+    if (compactGraph) {
+        compactGraph->appendNode(lat, lon);
+    }
+
+    nodes.emplace(id, &node);
+    return &node;
+}
+
 Node* RoadGraph::addNode(const std::string& id, double lat, double lon) {
-    auto node = std::make_unique<Node>();
-    node->id = id;
-    node->latitude = lat;
-    node->longitude = lon;
+    char* end = nullptr;
+    long long numericId = std::strtoll(id.c_str(), &end, 10);
+    if (id.empty() || *end != '\0' || isSyntheticId(numericId)) {
+        LOGE("Node id '%s' is not an OSM id, adding it as a synthetic node", id.c_str());
+        return addSyntheticNode(lat, lon);
+    }
+    return addNode(static_cast<int64_t>(numericId), lat, lon);
+}
 
-    Node* nodePtr = node.get();
-    nodes[id] = std::move(node);
-    return nodePtr;
+Node* RoadGraph::addSyntheticNode(double lat, double lon) {
+    return addNode(nextSyntheticId--, lat, lon);
 }
 
-RoadSegment* RoadGraph::addSegment(Node* start, Node* end, const std::string& name,
+RoadSegment* RoadGraph::addSegment(Node* start, Node* end, std::string_view name,
                                    double speedLimit, RoadType type) {
-    auto segment = std::make_unique<RoadSegment>();
+    RoadSegment* segment = &segmentStorage.emplace_back();
     segment->start = start;
     segment->end = end;
-    segment->name = name;
+    segment->name = *namePool.emplace(name).first;
     segment->speedLimit = speedLimit;
     segment->type = type;
     segment->length = haversineDistance(
@@ -185,17 +325,18 @@ RoadSegment* RoadGraph::addSegment(Node* start, Node* end, const std::string& na
     );
     segment->id = nextSegmentId++;
 
-    start->segments.push_back(segment.get());
+    start->segments.push_back(segment);
 
-    spatialIndex->addSegment(
-            segment.get(),
-            start->latitude, start->longitude,
-            end->latitude, end->longitude
-    );
+    if (compactGraph) {
+        compactGraph->appendEdge(start->index, CompactGraph::Edge{
+                end->index,
+                static_cast<float>(segment->length),
+                static_cast<float>(speedLimit),
+                type
+        });
+    }
 
-    RoadSegment* segmentPtr = segment.get();
-    segments.push_back(std::move(segment));
-    return segmentPtr;
+    return segment;
 }
 
 double RoadGraph::haversineDistance(double lat1, double lon1, double lat2, double lon2) {
@@ -7,14 +7,22 @@
 
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "location_filter.h"
 
-class SpatialIndex;
 class OSMParser;
+class CompactGraph;
+class SegmentRTree;
+class ContractionHierarchy;
+class LandmarkIndex;
 
 enum class RoadType {
     HIGHWAY,
@@ -29,7 +37,8 @@ struct Node;
 struct RoadSegment {
     Node* start;
     Node* end;
-    std::string name;
+    // Owned by the graph: interned when parsed, or inside the mapped snapshot.
+    std::string_view name;
     double speedLimit;
     RoadType type;
     double length;
@@ -41,7 +50,8 @@ struct RoadSegment {
 };
 
 struct Node {
-    std::string id;
+    int64_t id;
+    uint32_t index = 0;
     double latitude;
     double longitude;
     std::vector<RoadSegment*> segments;
@@ -49,32 +59,87 @@ struct Node {
 
 class RoadGraph {
 public:
-    RoadGraph();
+    // Bumped whenever parsing or freezing builds a different graph from the same source data,
+    // which invalidates snapshots cached by older builds. Version 2 drops nodes off routable ways.
+    static constexpr uint32_t BUILDER_VERSION = 2;
+
+    // Name given to ways that have neither a name nor a ref tag.
+    static constexpr std::string_view UNNAMED_ROAD = "Unnamed Road";
+
+    // `loaderThreadCount` is handed to the OSM parser; 0 uses every hardware thread.
+    explicit RoadGraph(size_t loaderThreadCount = 0);
     ~RoadGraph();
 
-    std::vector<RoadSegment*> findNearbyRoads(const Location& loc, double radius);
+    // Spatial queries use the segment R-tree built by freeze(); an unfrozen graph finds nothing.
+    // Segments added afterwards to split a segment for a route endpoint are routable but not indexed.
+    std::vector<RoadSegment*> findNearbyRoads(const Location& loc, double radius) const;
+    void findNearbyRoads(const Location& loc, double radius, std::vector<RoadSegment*>& result) const;
 
-    Node* getNode(const std::string& id);
+    void findNearestRoads(const Location& loc, size_t count, double maxRadius,
+                          std::vector<RoadSegment*>& result) const;
+
+    Node* getNode(int64_t id);
+    Node* getNodeByIndex(uint32_t index) { return &nodeStorage[index]; }
 
     bool loadOSMData(const std::string& filePath);
+    bool loadOSMBuffer(const char* data, size_t size);
+
+    size_t getNodesCount() const { return nodeStorage.size(); }
+    size_t getSegmentsCount() const { return segmentStorage.size(); }
 
-    size_t getNodesCount() const { return nodes.size(); }
-    size_t getSegmentsCount() const { return segments.size(); }
+    // Changes whenever the graph is reloaded, so caches derived from the adjacency can tell they
+    // are stale. Splitting a segment for a route endpoint leaves it unchanged: the detour through
+    // the new node is never shorter than the segment, so distances between existing nodes hold.
+    uint64_t getGeneration() const { return generation; }
 
+    // Readers that may run beside other threads hold this shared. Loading takes it exclusively
+    // itself; callers of addNode, addSegment and pinNode must hold it exclusively.
+    std::shared_mutex& getMutex() const { return graphMutex; }
+
+    Node* addNode(int64_t id, double lat, double lon);
     Node* addNode(const std::string& id, double lat, double lon);
 
-    RoadSegment* addSegment(Node* start, Node* end, const std::string& name,
+    Node* addSyntheticNode(double lat, double lon);
+
+    static bool isSyntheticId(int64_t id) { return id < 0; }
+
+    RoadSegment* addSegment(Node* start, Node* end, std::string_view name,
                             double speedLimit, RoadType type);
 
     static double haversineDistance(double lat1, double lon1, double lat2, double lon2);
 
+    void freeze();
+
+    bool saveSnapshot(const std::string& path, uint64_t sourceFingerprint) const;
+    bool loadSnapshot(const std::string& path, uint64_t sourceFingerprint = 0);
+
+    const CompactGraph* getCompactGraph() const { return compactGraph.get(); }
+    const ContractionHierarchy* getHierarchy() const { return hierarchy.get(); }
+    const LandmarkIndex* getLandmarks() const { return landmarks.get(); }
+
+    // Ensures a route can end at this node when it lies inside a contracted chain.
+    void pinNode(Node* node);
+
     void clear();
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<Node>> nodes;
-    std::vector<std::unique_ptr<RoadSegment>> segments;
-    std::unique_ptr<SpatialIndex> spatialIndex;
+    friend class GraphSnapshot;
+
+    std::unordered_map<int64_t, Node*> nodes;
+    std::deque<Node> nodeStorage;
+    std::deque<RoadSegment> segmentStorage;
     std::unique_ptr<OSMParser> osmParser;
+    std::unique_ptr<CompactGraph> compactGraph;
+    std::unique_ptr<SegmentRTree> segmentTree;
+    std::unique_ptr<ContractionHierarchy> hierarchy;
+    std::unique_ptr<LandmarkIndex> landmarks;
+    std::unordered_set<std::string> namePool;
+    std::shared_ptr<const void> snapshotStorage;
+
+    void buildSegmentTree();
 
     int nextSegmentId = 1;
+    int64_t nextSyntheticId = -1;
+    uint64_t generation = 0;
+    mutable std::shared_mutex graphMutex;
 };
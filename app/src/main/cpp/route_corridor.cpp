@@ -0,0 +1,276 @@
+/*
+ * File: route_corridor.cpp
+ * Description: Implementation of the RouteCorridor class, responsible for bucketing route legs and collecting the segments along them.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "route_corridor.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define LOG_TAG "RouteCorridor"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr double METERS_PER_DEGREE = 6371000.0 * M_PI / 180.0;
+constexpr double CELL_SIZE_METERS = 50.0;
+constexpr double COARSE_CELL_SIZE_METERS = 1000.0;
+constexpr int MAX_FINE_RINGS = 8;
+
+}
+
+RouteCorridor::RouteCorridor(double halfWidthMeters)
+        : halfWidth(halfWidthMeters),
+          cellSize(CELL_SIZE_METERS / METERS_PER_DEGREE),
+          coarseCellSize(COARSE_CELL_SIZE_METERS / METERS_PER_DEGREE) {
+}
+
+void RouteCorridor::clear() {
+    legs.clear();
+    cells.clear();
+    pointCells.clear();
+    segmentIds.clear();
+}
+
+void RouteCorridor::build(const std::vector<Location>& points, const RoadGraph& graph) {
+    clear();
+    if (points.size() < 2) {
+        return;
+    }
+
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        legs.push_back(Leg{points[i].latitude, points[i].longitude,
+                           points[i + 1].latitude, points[i + 1].longitude});
+    }
+
+    extent = {std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+              std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+
+    for (uint32_t i = 0; i < legs.size(); i++) {
+        const Leg& leg = legs[i];
+        double latPadding = halfWidth / METERS_PER_DEGREE;
+        double lonPadding = latPadding / std::cos(leg.startLat * M_PI / 180.0);
+
+        int minLatCell = toCell(std::min(leg.startLat, leg.endLat) - latPadding, cellSize);
+        int maxLatCell = toCell(std::max(leg.startLat, leg.endLat) + latPadding, cellSize);
+        int minLonCell = toCell(std::min(leg.startLon, leg.endLon) - lonPadding, cellSize);
+        int maxLonCell = toCell(std::max(leg.startLon, leg.endLon) + lonPadding, cellSize);
+
+        for (int latCell = minLatCell; latCell <= maxLatCell; latCell++) {
+            for (int lonCell = minLonCell; lonCell <= maxLonCell; lonCell++) {
+                cells[cellKey(latCell, lonCell)].push_back(i);
+            }
+        }
+
+        extent.minLat = std::min(extent.minLat, minLatCell);
+        extent.maxLat = std::max(extent.maxLat, maxLatCell);
+        extent.minLon = std::min(extent.minLon, minLonCell);
+        extent.maxLon = std::max(extent.maxLon, maxLonCell);
+    }
+
+    coarseExtent = {std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+                    std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+    for (size_t i = 0; i < points.size(); i++) {
+        int latCell = toCell(points[i].latitude, coarseCellSize);
+        int lonCell = toCell(points[i].longitude, coarseCellSize);
+        pointCells[cellKey(latCell, lonCell)].push_back(static_cast<uint32_t>(i));
+
+        coarseExtent.minLat = std::min(coarseExtent.minLat, latCell);
+        coarseExtent.maxLat = std::max(coarseExtent.maxLat, latCell);
+        coarseExtent.minLon = std::min(coarseExtent.minLon, lonCell);
+        coarseExtent.maxLon = std::max(coarseExtent.maxLon, lonCell);
+    }
+
+    // Any segment with an end near a leg lies within half the leg length plus the width of its middle.
+    std::vector<RoadSegment*> nearby;
+    for (const Leg& leg : legs) {
+        Location middle((leg.startLat + leg.endLat) / 2.0, (leg.startLon + leg.endLon) / 2.0, 0.0f, 0.0f);
+        double length = RoadGraph::haversineDistance(leg.startLat, leg.startLon, leg.endLat, leg.endLon);
+        graph.findNearbyRoads(middle, length / 2.0 + halfWidth, nearby);
+
+        for (RoadSegment* segment : nearby) {
+            if (!segmentIds.count(segment->id) && isNearRoute(segment)) {
+                segmentIds.insert(segment->id);
+            }
+        }
+    }
+
+    LOGI("Route corridor holds %zu segments in %zu cells", segmentIds.size(), cells.size());
+}
+
+bool RouteCorridor::contains(const RoadSegment* segment) const {
+    return segmentIds.count(segment->id) > 0;
+}
+
+bool RouteCorridor::isNearRoute(const RoadSegment* segment) const {
+    return distanceToRoute(segment->start->latitude, segment->start->longitude) < halfWidth ||
+           distanceToRoute(segment->end->latitude, segment->end->longitude) < halfWidth;
+}
+
+double RouteCorridor::distanceToRoute(double lat, double lon) const {
+    double best = std::numeric_limits<double>::infinity();
+
+    auto it = cells.find(cellKey(toCell(lat, cellSize), toCell(lon, cellSize)));
+    if (it == cells.end()) {
+        return best;
+    }
+    for (uint32_t leg : it->second) {
+        best = std::min(best, distanceToLeg(lat, lon, legs[leg]));
+    }
+    return best <= halfWidth ? best : std::numeric_limits<double>::infinity();
+}
+
+int RouteCorridor::nearestPoint(double lat, double lon) const {
+    if (legs.empty()) {
+        return -1;
+    }
+
+    int bestPoint = -1;
+    double bestDistance = std::numeric_limits<double>::infinity();
+    double metersPerDegreeLon = METERS_PER_DEGREE * std::cos(lat * M_PI / 180.0);
+
+    auto consider = [&](double pointLat, double pointLon, int point) {
+        double dx = (pointLon - lon) * metersPerDegreeLon;
+        double dy = (pointLat - lat) * METERS_PER_DEGREE;
+        double distance = std::sqrt(dx * dx + dy * dy);
+        if (distance < bestDistance || (distance == bestDistance && point < bestPoint)) {
+            bestDistance = distance;
+            bestPoint = point;
+        }
+    };
+
+    // Every route point is an end of a leg listed in the fine cell holding it.
+    bool settled = searchRings(lat, lon, cellSize, extent, MAX_FINE_RINGS, bestDistance,
+                               [&](int cellLat, int cellLon) {
+        auto it = cells.find(cellKey(cellLat, cellLon));
+        if (it == cells.end()) {
+            return;
+        }
+        for (uint32_t leg : it->second) {
+            consider(legs[leg].startLat, legs[leg].startLon, static_cast<int>(leg));
+            consider(legs[leg].endLat, legs[leg].endLon, static_cast<int>(leg) + 1);
+        }
+    });
+    if (settled) {
+        return bestPoint;
+    }
+
+    // Far from every leg the fine rings grow quadratically; coarse cells cover the same distance in a few rings.
+    searchRings(lat, lon, coarseCellSize, coarseExtent, std::numeric_limits<int>::max(), bestDistance,
+                [&](int cellLat, int cellLon) {
+        auto it = pointCells.find(cellKey(cellLat, cellLon));
+        if (it == pointCells.end()) {
+            return;
+        }
+        for (uint32_t point : it->second) {
+            // Point i starts leg i; only the last point is the end of a leg alone.
+            if (point < legs.size()) {
+                consider(legs[point].startLat, legs[point].startLon, static_cast<int>(point));
+            } else {
+                consider(legs.back().endLat, legs.back().endLon, static_cast<int>(point));
+            }
+        }
+    });
+    return bestPoint;
+}
+
+template <typename Visitor>
+bool RouteCorridor::searchRings(double lat, double lon, double size, const CellRange& range, int maxRings,
+                                const double& bestDistance, Visitor&& visit) const {
+    int latCell = toCell(lat, size);
+    int lonCell = toCell(lon, size);
+
+    // Rings that cannot reach the range are skipped outright, and each ring is clipped to it.
+    int firstRing = std::max({range.minLat - latCell, latCell - range.maxLat,
+                              range.minLon - lonCell, lonCell - range.maxLon, 0});
+    int lastRing = std::max({latCell - range.minLat, range.maxLat - latCell,
+                             lonCell - range.minLon, range.maxLon - lonCell, 0});
+    int stopRing = lastRing - firstRing > maxRings ? firstRing + maxRings : lastRing;
+
+    for (int ring = firstRing; ring <= stopRing; ring++) {
+        if (distanceToRing(lat, lon, latCell, lonCell, ring, size) > bestDistance) {
+            return true;
+        }
+
+        int minLon = std::max(lonCell - ring, range.minLon);
+        int maxLon = std::min(lonCell + ring, range.maxLon);
+        for (int rowLat : {latCell - ring, latCell + ring}) {
+            if (rowLat >= range.minLat && rowLat <= range.maxLat) {
+                for (int cellLon = minLon; cellLon <= maxLon; cellLon++) {
+                    visit(rowLat, cellLon);
+                }
+            }
+            if (ring == 0) {
+                break;
+            }
+        }
+
+        int minLat = std::max(latCell - ring + 1, range.minLat);
+        int maxLat = std::min(latCell + ring - 1, range.maxLat);
+        for (int columnLon : {lonCell - ring, lonCell + ring}) {
+            if (ring > 0 && columnLon >= range.minLon && columnLon <= range.maxLon) {
+                for (int cellLat = minLat; cellLat <= maxLat; cellLat++) {
+                    visit(cellLat, columnLon);
+                }
+            }
+        }
+    }
+    return stopRing == lastRing || distanceToRing(lat, lon, latCell, lonCell, stopRing + 1, size) > bestDistance;
+}
+
+double RouteCorridor::distanceAroundPoint(size_t point, double lat, double lon) const {
+    double distance = std::numeric_limits<double>::infinity();
+    if (point > 0 && point - 1 < legs.size()) {
+        distance = distanceToLeg(lat, lon, legs[point - 1]);
+    }
+    if (point < legs.size()) {
+        distance = std::min(distance, distanceToLeg(lat, lon, legs[point]));
+    }
+    return distance;
+}
+
+double RouteCorridor::distanceToRing(double lat, double lon, int latCell, int lonCell, int ring, double size) {
+    if (ring == 0) {
+        return 0.0;
+    }
+
+    double metersPerDegreeLon = METERS_PER_DEGREE * std::cos(lat * M_PI / 180.0);
+
+    double south = (lat - (latCell - ring + 1) * size) * METERS_PER_DEGREE;
+    double north = ((latCell + ring) * size - lat) * METERS_PER_DEGREE;
+    double west = (lon - (lonCell - ring + 1) * size) * metersPerDegreeLon;
+    double east = ((lonCell + ring) * size - lon) * metersPerDegreeLon;
+
+    return std::min({south, north, west, east});
+}
+
+double RouteCorridor::distanceToLeg(double lat, double lon, const Leg& leg) {
+    // Local planar approximation around the query point, accurate over leg-sized distances.
+    double metersPerDegreeLon = METERS_PER_DEGREE * std::cos(lat * M_PI / 180.0);
+    double ax = (leg.startLon - lon) * metersPerDegreeLon;
+    double ay = (leg.startLat - lat) * METERS_PER_DEGREE;
+    double bx = (leg.endLon - lon) * metersPerDegreeLon;
+    double by = (leg.endLat - lat) * METERS_PER_DEGREE;
+
+    double dx = bx - ax;
+    double dy = by - ay;
+    double lengthSquared = dx * dx + dy * dy;
+    double t = lengthSquared > 0.0 ? std::clamp(-(ax * dx + ay * dy) / lengthSquared, 0.0, 1.0) : 0.0;
+
+    double px = ax + t * dx;
+    double py = ay + t * dy;
+    return std::sqrt(px * px + py * py);
+}
+
+int RouteCorridor::toCell(double degrees, double size) {
+    return static_cast<int>(std::floor(degrees / size));
+}
+
+uint64_t RouteCorridor::cellKey(int latCell, int lonCell) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(latCell)) << 32) |
+           static_cast<uint32_t>(lonCell);
+}
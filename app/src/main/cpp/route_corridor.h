@@ -0,0 +1,81 @@
+/*
+ * File: route_corridor.h
+ * Description: Header file for the RouteCorridor class, the set of road segments running along the active route.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "location_filter.h"
+#include "road_graph.h"
+
+// A road segment belongs to the corridor when one of its ends lies within the half width of a
+// route leg. Legs are bucketed into grid cells padded by the half width, so a point only has to
+// be tested against the legs of its own cell. Every segment of the graph that qualifies is found
+// once when the route is set, which turns the on-route test into a hash lookup. Route points are
+// also bucketed once into coarse cells, which keep nearest-point searches far off the route short.
+class RouteCorridor {
+public:
+    explicit RouteCorridor(double halfWidthMeters);
+
+    void build(const std::vector<Location>& points, const RoadGraph& graph);
+    void clear();
+
+    // Segments the route itself was matched to belong to the corridor regardless of distance.
+    void insert(const RoadSegment* segment) { segmentIds.insert(segment->id); }
+
+    bool contains(const RoadSegment* segment) const;
+
+    // Distance to the closest route leg, or infinity when no leg is within the half width.
+    double distanceToRoute(double lat, double lon) const;
+
+    // Index of the route point closest to the location at any distance, or -1 without legs.
+    int nearestPoint(double lat, double lon) const;
+
+    // Distance to the legs on either side of a route point.
+    double distanceAroundPoint(size_t point, double lat, double lon) const;
+
+private:
+    struct Leg {
+        double startLat;
+        double startLon;
+        double endLat;
+        double endLon;
+    };
+
+    struct CellRange {
+        int minLat;
+        int maxLat;
+        int minLon;
+        int maxLon;
+    };
+
+    double halfWidth;
+    double cellSize;
+    double coarseCellSize;
+    std::vector<Leg> legs;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> pointCells;
+    std::unordered_set<int> segmentIds;
+    CellRange extent = {0, 0, 0, 0};
+    CellRange coarseExtent = {0, 0, 0, 0};
+
+    bool isNearRoute(const RoadSegment* segment) const;
+
+    // Visits the cells of square rings around the location, clipped to `range`, until no unvisited
+    // cell can be closer than `bestDistance`. Returns false when `maxRings` cut the search short.
+    template <typename Visitor>
+    bool searchRings(double lat, double lon, double size, const CellRange& range, int maxRings,
+                     const double& bestDistance, Visitor&& visit) const;
+
+    static double distanceToRing(double lat, double lon, int latCell, int lonCell, int ring, double size);
+    static int toCell(double degrees, double size);
+    static uint64_t cellKey(int latCell, int lonCell);
+    static double distanceToLeg(double lat, double lon, const Leg& leg);
+};
@@ -8,6 +8,8 @@
 #include "route_matcher.h"
 #include <android/log.h>
 #include <limits>
+#include <mutex>
+#include <shared_mutex>
 #include <cmath>
 #include <algorithm>
 
@@ -18,17 +20,23 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 constexpr double MAX_DISTANCE_TO_SEGMENT = 50.0;
-constexpr double BEARING_WEIGHT = 0.5;
-constexpr double DISTANCE_WEIGHT = 1.0;
 constexpr double SEGMENT_SEARCH_RADIUS = 100.0;
+constexpr double ROUTE_CORRIDOR_HALF_WIDTH = 20.0;
+constexpr int ROUTE_WINDOW_BEHIND = 10;
+constexpr int ROUTE_WINDOW_AHEAD = 30;
+constexpr double OFF_ROUTE_DISTANCE = 50.0;
+constexpr double MANEUVER_MIN_ANGLE = 30.0;
 
 RouteMatcher::RouteMatcher(RoadGraph* graph)
-        : roadGraph(graph) {
+        : roadGraph(graph),
+          hmmMatcher(graph),
+          routeCorridor(ROUTE_CORRIDOR_HALF_WIDTH) {
     LOGI("RouteMatcher created");
 }
 
 RouteMatch RouteMatcher::match(const Location& loc) {
     LOGD("Matching location: %.6f, %.6f", loc.latitude, loc.longitude);
+    std::shared_lock<std::shared_mutex> lock(roadGraph->getMutex());
 
     lastLocation = loc;
 
@@ -59,41 +67,40 @@ RouteMatch RouteMatcher::match(const Location& loc) {
         return match;
     }
 
-    std::vector<RoadSegment*> nearbyRoads = roadGraph->findNearbyRoads(loc, SEGMENT_SEARCH_RADIUS);
+    std::vector<RoadSegment*>& nearbyRoads = nearbyBuffer;
+    roadGraph->findNearbyRoads(loc, SEGMENT_SEARCH_RADIUS, nearbyRoads);
     LOGD("Found %zu nearby road segments", nearbyRoads.size());
 
     if (nearbyRoads.empty()) {
         LOGD("No roads within %f meters, increasing search radius", SEGMENT_SEARCH_RADIUS);
-        nearbyRoads = roadGraph->findNearbyRoads(loc, SEGMENT_SEARCH_RADIUS * 3);
+        roadGraph->findNearbyRoads(loc, SEGMENT_SEARCH_RADIUS * 3, nearbyRoads);
         LOGD("Found %zu road segments with expanded search", nearbyRoads.size());
     }
 
-    RoadSegment* bestSegment = nullptr;
-    double bestScore = std::numeric_limits<double>::max();
-    Location matchedLocation = loc;
-
-    std::vector<RoadSegment*> routeSegments;
+    std::vector<RoadSegment*>& onRouteSegments = onRouteBuffer;
+    onRouteSegments.clear();
     for (RoadSegment* segment : nearbyRoads) {
 
         if (isSegmentOnRoute(segment)) {
-            routeSegments.push_back(segment);
+            onRouteSegments.push_back(segment);
         }
     }
 
     const std::vector<RoadSegment*>& segmentsToCheck =
-            routeSegments.empty() ? nearbyRoads : routeSegments;
-
-    for (RoadSegment* segment : segmentsToCheck) {
-        double score = calculateMatchScore(segment, loc);
-        if (score < bestScore) {
-            bestScore = score;
-            bestSegment = segment;
-            matchedLocation = projectOntoSegment(loc, *segment);
-        }
+            onRouteSegments.empty() ? nearbyRoads : onRouteSegments;
+
+    RoadSegment* bestSegment = nullptr;
+    Location matchedLocation = loc;
+
+    std::optional<HmmMapMatcher::Candidate> candidate = hmmMatcher.update(loc, segmentsToCheck);
+    if (candidate && candidate->distance <= MAX_DISTANCE_TO_SEGMENT) {
+        bestSegment = candidate->segment;
+        matchedLocation = projectOntoSegment(loc, *bestSegment);
     }
 
-    LOGD("Map matching score: %f, matched to segment: %s",
-         bestScore, bestSegment ? bestSegment->name.c_str() : "none");
+    std::string_view matchedName = bestSegment ? bestSegment->name : "none";
+    LOGD("Map matching distance: %f, matched to segment: %.*s",
+         candidate ? candidate->distance : -1.0, static_cast<int>(matchedName.size()), matchedName.data());
 
     return createRouteMatch(matchedLocation, bestSegment, closestPointIndex);
 }
@@ -102,54 +109,22 @@ bool RouteMatcher::isSegmentOnRoute(RoadSegment* segment) {
     if (!currentRoute || !segment) {
         return false;
     }
-
-    double startLat = segment->start->latitude;
-    double startLon = segment->start->longitude;
-    double endLat = segment->end->latitude;
-    double endLon = segment->end->longitude;
-
-    const auto& points = currentRoute->points;
-
-    for (size_t i = 0; i < points.size() - 1; i++) {
-        double routeSegStartLat = points[i].latitude;
-        double routeSegStartLon = points[i].longitude;
-        double routeSegEndLat = points[i + 1].latitude;
-        double routeSegEndLon = points[i + 1].longitude;
-
-        double startToRouteStart = roadGraph->haversineDistance(
-                startLat, startLon, routeSegStartLat, routeSegStartLon);
-        double startToRouteEnd = roadGraph->haversineDistance(
-                startLat, startLon, routeSegEndLat, routeSegEndLon);
-        double endToRouteStart = roadGraph->haversineDistance(
-                endLat, endLon, routeSegStartLat, routeSegStartLon);
-        double endToRouteEnd = roadGraph->haversineDistance(
-                endLat, endLon, routeSegEndLat, routeSegEndLon);
-
-        const double MATCH_THRESHOLD = 20.0;
-        if (startToRouteStart < MATCH_THRESHOLD || startToRouteEnd < MATCH_THRESHOLD ||
-            endToRouteStart < MATCH_THRESHOLD || endToRouteEnd < MATCH_THRESHOLD) {
-            return true;
-        }
-
-        double distance = calculateSegmentToSegmentDistance(
-                startLat, startLon, endLat, endLon,
-                routeSegStartLat, routeSegStartLon, routeSegEndLat, routeSegEndLon);
-
-        if (distance < MATCH_THRESHOLD) {
-            return true;
-        }
-    }
-
-    return false;
+    return routeCorridor.contains(segment);
 }
 
 void RouteMatcher::setRoute(const Route& route) {
     LOGI("Setting route with %zu points", route.points.size());
+    std::shared_lock<std::shared_mutex> lock(roadGraph->getMutex());
     currentRoute = route;
+    progressIndex = -1;
+    hmmMatcher.reset();
 
     validateRouteIntegrity();
 
+    routeCorridor.build(route.points, *roadGraph);
+
     cumulativeDistances.clear();
+    maneuvers.clear();
     if (route.points.empty()) return;
 
     cumulativeDistances.push_back(0.0);
@@ -169,6 +144,11 @@ void RouteMatcher::setRoute(const Route& route) {
     LOGI("Route total distance: %.1f meters", cumulativeDistances.back());
 
     precalculateRouteSegments();
+    for (RoadSegment* segment : routeSegments) {
+        routeCorridor.insert(segment);
+    }
+
+    precalculateManeuvers();
 }
 
 void RouteMatcher::validateRouteIntegrity() {
@@ -195,6 +175,7 @@ void RouteMatcher::validateRouteIntegrity() {
 
 void RouteMatcher::precalculateRouteSegments() {
     routeSegments.clear();
+    legStreetNames.clear();
 
     if (!currentRoute || currentRoute->points.size() < 2) {
         return;
@@ -251,9 +232,12 @@ void RouteMatcher::precalculateRouteSegments() {
             }
         }
 
+        legStreetNames.emplace_back(bestSegment ? bestSegment->name : "");
+
         if (bestSegment) {
             routeSegments.push_back(bestSegment);
-            LOGD("Route segment %zu matched to road: %s", i, bestSegment->name.c_str());
+            LOGD("Route segment %zu matched to road: %.*s", i,
+                 static_cast<int>(bestSegment->name.size()), bestSegment->name.data());
         } else {
             LOGD("No matching road segment found for route segment %zu", i);
         }
@@ -262,6 +246,60 @@ void RouteMatcher::precalculateRouteSegments() {
     LOGI("Precalculated %zu road segments for route", routeSegments.size());
 }
 
+void RouteMatcher::precalculateManeuvers() {
+    maneuvers.clear();
+
+    if (!currentRoute || currentRoute->points.empty()) {
+        return;
+    }
+
+    const auto& points = currentRoute->points;
+    int lastPoint = static_cast<int>(points.size()) - 1;
+
+    for (int i = 1; i < lastPoint; i++) {
+        double bearingIn = calculateBearing(
+                points[i-1].latitude, points[i-1].longitude,
+                points[i].latitude, points[i].longitude
+        );
+
+        double bearingOut = calculateBearing(
+                points[i].latitude, points[i].longitude,
+                points[i+1].latitude, points[i+1].longitude
+        );
+
+        double angle = bearingOut - bearingIn;
+        while (angle > 180.0) angle -= 360.0;
+        while (angle < -180.0) angle += 360.0;
+
+        if (std::abs(angle) <= MANEUVER_MIN_ANGLE) {
+            continue;
+        }
+
+        ManeuverType type;
+        if (angle >= 120.0) {
+            type = ManeuverType::SHARP_RIGHT;
+        } else if (angle >= 60.0) {
+            type = ManeuverType::RIGHT;
+        } else if (angle > 0.0) {
+            type = ManeuverType::SLIGHT_RIGHT;
+        } else if (angle <= -120.0) {
+            type = ManeuverType::SHARP_LEFT;
+        } else if (angle <= -60.0) {
+            type = ManeuverType::LEFT;
+        } else {
+            type = ManeuverType::SLIGHT_LEFT;
+        }
+
+        maneuvers.push_back(Maneuver{i, type, describeManeuver(type, legStreetNames[i-1], legStreetNames[i]),
+                                     cumulativeDistances[i]});
+    }
+
+    maneuvers.push_back(Maneuver{lastPoint, ManeuverType::ARRIVE, describeManeuver(ManeuverType::ARRIVE, "", ""),
+                                 cumulativeDistances[lastPoint]});
+
+    LOGI("Precalculated %zu maneuvers for route", maneuvers.size());
+}
+
 int RouteMatcher::findClosestPointOnRoute(const Location& loc) {
     if (!currentRoute || currentRoute->points.empty()) {
         return -1;
@@ -272,19 +310,45 @@ int RouteMatcher::findClosestPointOnRoute(const Location& loc) {
     int closestIdx = -1;
     double closestDist = std::numeric_limits<double>::max();
 
-    for (size_t i = 0; i < points.size(); i++) {
-        const auto& point = points[i];
-        double dist = roadGraph->haversineDistance(
-                loc.latitude, loc.longitude,
-                point.latitude, point.longitude
-        );
+    auto scan = [&](int first, int last) {
+        for (int i = first; i <= last; i++) {
+            double dist = roadGraph->haversineDistance(
+                    loc.latitude, loc.longitude,
+                    points[i].latitude, points[i].longitude
+            );
 
-        if (dist < closestDist) {
-            closestDist = dist;
-            closestIdx = static_cast<int>(i);
+            if (dist < closestDist) {
+                closestDist = dist;
+                closestIdx = i;
+            }
+        }
+    };
+
+    // Progress along the route is continuous, so only a window around the last match is searched.
+    if (progressIndex >= 0) {
+        int lastPoint = static_cast<int>(points.size()) - 1;
+        int windowEnd = std::min(lastPoint, progressIndex + ROUTE_WINDOW_AHEAD);
+        scan(std::max(0, progressIndex - ROUTE_WINDOW_BEHIND), windowEnd);
+
+        // Slide further ahead while the closest point is still the front of the window.
+        while (closestIdx == windowEnd && windowEnd < lastPoint) {
+            int next = std::min(lastPoint, windowEnd + ROUTE_WINDOW_AHEAD);
+            scan(windowEnd + 1, next);
+            windowEnd = next;
+        }
+
+        // Points can be far apart on straight roads, so being off route is judged by the legs.
+        double routeDist = routeCorridor.distanceAroundPoint(closestIdx, loc.latitude, loc.longitude);
+        if (closestDist > OFF_ROUTE_DISTANCE && routeDist > OFF_ROUTE_DISTANCE) {
+            LOGD("%.1f meters from the route window, searching the whole route", routeDist);
+            closestIdx = -1;
         }
     }
 
+    if (closestIdx < 0) {
+        closestIdx = std::max(0, routeCorridor.nearestPoint(loc.latitude, loc.longitude));
+    }
+
     if (closestIdx < static_cast<int>(points.size() - 1)) {
         const auto& point = points[closestIdx];
         const auto& nextPoint = points[closestIdx + 1];
@@ -318,89 +382,10 @@ int RouteMatcher::findClosestPointOnRoute(const Location& loc) {
         }
     }
 
+    progressIndex = closestIdx;
     return closestIdx;
 }
 
-double RouteMatcher::calculateMatchScore(const RoadSegment* segment, const Location& loc) {
-    if (!segment) return std::numeric_limits<double>::max();
-
-    Location projected = projectOntoSegment(loc, *segment);
-
-    double perpDistance = roadGraph->haversineDistance(
-            loc.latitude, loc.longitude,
-            projected.latitude, projected.longitude
-    );
-
-    if (perpDistance > MAX_DISTANCE_TO_SEGMENT) {
-        return std::numeric_limits<double>::max();
-    }
-
-    double segmentBearing = calculateBearing(
-            segment->start->latitude, segment->start->longitude,
-            segment->end->latitude, segment->end->longitude
-    );
-
-    double bearingDiff = std::abs(segmentBearing - loc.bearing);
-    if (bearingDiff > 180.0) {
-        bearingDiff = 360.0 - bearingDiff;
-    }
-
-    double bearingFactor = bearingDiff / 180.0;
-
-    bool isOnRoute = false;
-    if (currentRoute) {
-        isOnRoute = std::find(routeSegments.begin(), routeSegments.end(), segment) != routeSegments.end();
-    }
-
-    double routeBonus = isOnRoute ? 0.5 : 1.0;
-
-    double speedFactor = 1.0;
-    if (loc.speed > 1.0f) {
-
-        if (segment->speedLimit > 60.0) {
-            speedFactor = 0.8;
-        } else if (segment->speedLimit < 30.0 && loc.speed > 10.0f) {
-            speedFactor = 1.2;
-        }
-    } else if (loc.speed < 5.0f && segment->speedLimit > 70.0) {
-        speedFactor = 1.2;
-    }
-
-    double score = (DISTANCE_WEIGHT * perpDistance +
-                    BEARING_WEIGHT * bearingFactor * 50.0) *
-                   routeBonus * speedFactor;
-    return score;
-}
-
-double RouteMatcher::calculateSegmentToSegmentDistance(
-        double lat1a, double lon1a, double lat1b, double lon1b,
-        double lat2a, double lon2a, double lat2b, double lon2b) {
-
-    Location loc1a{lat1a, lon1a, 0.0f, 0.0f};
-    Location loc1b{lat1b, lon1b, 0.0f, 0.0f};
-
-    RoadSegment segment;
-    segment.start = new Node();
-    segment.end = new Node();
-    segment.start->latitude = lat2a;
-    segment.start->longitude = lon2a;
-    segment.end->latitude = lat2b;
-    segment.end->longitude = lon2b;
-
-    Location proj1a = projectOntoSegment(loc1a, segment);
-    Location proj1b = projectOntoSegment(loc1b, segment);
-
-    double dist1a = roadGraph->haversineDistance(
-            lat1a, lon1a, proj1a.latitude, proj1a.longitude);
-    double dist1b = roadGraph->haversineDistance(
-            lat1b, lon1b, proj1b.latitude, proj1b.longitude);
-
-    delete segment.start;
-    delete segment.end;
-
-    return std::min(dist1a, dist1b);
-}
-
 Location RouteMatcher::projectOntoSegment(const Location& loc, const RoadSegment& segment) {
 
     double x1 = segment.start->longitude;
@@ -461,15 +446,15 @@ RouteMatch RouteMatcher::createRouteMatch(
     if (currentRoute && closestPointIndex >= 0) {
         const auto& points = currentRoute->points;
 
-        int nextManeuverIndex = findNextManeuverPoint(closestPointIndex);
+        const Maneuver* nextManeuver = findNextManeuver(closestPointIndex);
 
-        if (nextManeuverIndex > closestPointIndex) {
+        if (nextManeuver && nextManeuver->type != ManeuverType::ARRIVE) {
 
             distanceToNext = static_cast<int>(
-                    cumulativeDistances[nextManeuverIndex] - cumulativeDistances[closestPointIndex]
+                    nextManeuver->distance - cumulativeDistances[closestPointIndex]
             );
 
-            match.nextManeuver = determineNextManeuver(closestPointIndex, nextManeuverIndex);
+            match.nextManeuver = nextManeuver->instruction;
         } else {
 
             match.nextManeuver = "Arrive at destination";
@@ -493,81 +478,43 @@ RouteMatch RouteMatcher::createRouteMatch(
     return match;
 }
 
-int RouteMatcher::findNextManeuverPoint(int currentIndex) {
-    if (!currentRoute || currentRoute->points.empty() ||
-        currentIndex < 0 || currentIndex >= static_cast<int>(currentRoute->points.size())) {
-        return -1;
-    }
-
-    const auto& points = currentRoute->points;
-
-    for (int i = currentIndex + 1; i < static_cast<int>(points.size()) - 1; i++) {
-
-        double bearing1 = calculateBearing(
-                points[i-1].latitude, points[i-1].longitude,
-                points[i].latitude, points[i].longitude
-        );
-
-        double bearing2 = calculateBearing(
-                points[i].latitude, points[i].longitude,
-                points[i+1].latitude, points[i+1].longitude
-        );
-
-        double bearingDiff = std::abs(bearing1 - bearing2);
-        if (bearingDiff > 180.0) {
-            bearingDiff = 360.0 - bearingDiff;
-        }
-
-        if (bearingDiff > 30.0) {
-            return i;
-        }
-    }
-
-    return static_cast<int>(points.size() - 1);
+const RouteMatcher::Maneuver* RouteMatcher::findNextManeuver(int currentIndex) const {
+    auto next = std::upper_bound(maneuvers.begin(), maneuvers.end(), currentIndex,
+                                 [](int index, const Maneuver& maneuver) { return index < maneuver.index; });
+    return next != maneuvers.end() ? &*next : nullptr;
 }
 
-std::string RouteMatcher::determineNextManeuver(int currentIndex, int maneuverIndex) {
-    if (!currentRoute || currentRoute->points.empty() ||
-        currentIndex < 0 || maneuverIndex <= currentIndex ||
-        maneuverIndex >= static_cast<int>(currentRoute->points.size())) {
-        return "Follow route";
+std::string RouteMatcher::describeManeuver(ManeuverType type, const std::string& streetIn,
+                                           const std::string& streetOut) {
+    std::string instruction;
+    switch (type) {
+        case ManeuverType::SLIGHT_RIGHT:
+            instruction = "Turn slight right";
+            break;
+        case ManeuverType::RIGHT:
+            instruction = "Turn right";
+            break;
+        case ManeuverType::SHARP_RIGHT:
+            instruction = "Make a sharp right";
+            break;
+        case ManeuverType::SLIGHT_LEFT:
+            instruction = "Turn slight left";
+            break;
+        case ManeuverType::LEFT:
+            instruction = "Turn left";
+            break;
+        case ManeuverType::SHARP_LEFT:
+            instruction = "Make a sharp left";
+            break;
+        case ManeuverType::ARRIVE:
+            return "Arrive at destination";
     }
 
-    const auto& points = currentRoute->points;
-
-    double currentBearing = calculateBearing(
-            points[maneuverIndex-1].latitude, points[maneuverIndex-1].longitude,
-            points[maneuverIndex].latitude, points[maneuverIndex].longitude
-    );
-
-    double nextBearing = calculateBearing(
-            points[maneuverIndex].latitude, points[maneuverIndex].longitude,
-            points[maneuverIndex+1 < static_cast<int>(points.size()) ? maneuverIndex+1 : maneuverIndex].latitude,
-            points[maneuverIndex+1 < static_cast<int>(points.size()) ? maneuverIndex+1 : maneuverIndex].longitude
-    );
-
-    double angle = nextBearing - currentBearing;
-
-    while (angle > 180.0) angle -= 360.0;
-    while (angle < -180.0) angle += 360.0;
-
-    if (std::abs(angle) < 20.0) {
-        return "Continue straight";
-    } else if (angle >= 20.0 && angle < 60.0) {
-        return "Turn slight right";
-    } else if (angle >= 60.0 && angle < 120.0) {
-        return "Turn right";
-    } else if (angle >= 120.0) {
-        return "Make a sharp right";
-    } else if (angle <= -20.0 && angle > -60.0) {
-        return "Turn slight left";
-    } else if (angle <= -60.0 && angle > -120.0) {
-        return "Turn left";
-    } else if (angle <= -120.0) {
-        return "Make a sharp left";
+    if (streetOut.empty() || streetOut == RoadGraph::UNNAMED_ROAD) {
+        return instruction;
     }
-
-    return "Follow route";
+    // A bend that keeps to the same street is still announced, but as staying on it.
+    return instruction + (streetOut == streetIn ? " to stay on " : " onto ") + streetOut;
 }
 
 double RouteMatcher::calculateBearing(double lat1, double lon1, double lat2, double lon2) {
@@ -10,7 +10,9 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include "hmm_map_matcher.h"
 #include "location_filter.h"
+#include "route_corridor.h"
 #include "road_graph.h"
 
 struct RouteMatch {
@@ -39,25 +41,47 @@ public:
     void setRoute(const Route& route);
 
 private:
+    enum class ManeuverType {
+        SLIGHT_RIGHT,
+        RIGHT,
+        SHARP_RIGHT,
+        SLIGHT_LEFT,
+        LEFT,
+        SHARP_LEFT,
+        ARRIVE
+    };
+
+    // A turn along the route, found and worded once in setRoute so that a match only has to look it up.
+    struct Maneuver {
+        int index;
+        ManeuverType type;
+        std::string instruction;
+        double distance;
+    };
+
     RoadGraph* roadGraph;
     std::optional<Route> currentRoute;
     std::optional<Location> lastLocation;
+    int progressIndex = -1;
     std::vector<double> cumulativeDistances;
     std::vector<RoadSegment*> routeSegments;
+    std::vector<std::string> legStreetNames;
+    std::vector<Maneuver> maneuvers;
+    std::vector<RoadSegment*> nearbyBuffer;
+    std::vector<RoadSegment*> onRouteBuffer;
+    HmmMapMatcher hmmMatcher;
+    RouteCorridor routeCorridor;
 
     int findClosestPointOnRoute(const Location& loc);
-    double calculateMatchScore(const RoadSegment* segment, const Location& loc);
     Location projectOntoSegment(const Location& loc, const RoadSegment& segment);
     RouteMatch createRouteMatch(const Location& matched, const RoadSegment* segment, int closestPointIndex);
-    int findNextManeuverPoint(int currentIndex);
-    std::string determineNextManeuver(int currentIndex, int maneuverIndex);
+    const Maneuver* findNextManeuver(int currentIndex) const;
+    static std::string describeManeuver(ManeuverType type, const std::string& streetIn, const std::string& streetOut);
     double calculateBearing(double lat1, double lon1, double lat2, double lon2);
 
     bool isSegmentOnRoute(RoadSegment* segment);
     void precalculateRouteSegments();
-    double calculateSegmentToSegmentDistance(
-            double lat1a, double lon1a, double lat1b, double lon1b,
-            double lat2a, double lon2a, double lat2b, double lon2b);
+    void precalculateManeuvers();
 
     void validateRouteIntegrity();
 };
@@ -6,14 +6,16 @@
  */
 
 #include "routing_engine.h"
+#include "contraction_hierarchy.h"
+#include "thread_pool.h"
+#include "via_node_alternatives.h"
 #include <android/log.h>
-#include <queue>
-#include <unordered_map>
-#include <unordered_set>
 #include <random>
 #include <cmath>
-#include <functional>
 #include <algorithm>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
 
 #define LOG_TAG "RoutingEngine"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
@@ -21,15 +23,22 @@
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
 constexpr double MAX_ROUTE_DISTANCE = 10000.0;
+constexpr double MAX_HIERARCHY_ROUTE_DISTANCE = 500000.0;
 constexpr double NODE_SEARCH_RADIUS = 10000.0;
 constexpr int MAX_ROUTE_POINTS = 1000;
 constexpr double ROUTE_POINT_SPACING = 25.0;
+constexpr size_t NEAREST_SEGMENT_CANDIDATES = 8;
+constexpr size_t MAX_ALTERNATIVES = 2;
+constexpr size_t SHORTEST_PATH_TREES = 2;
 
 RoutingEngine::RoutingEngine(RoadGraph* graph)
-        : roadGraph(graph) {
+        : roadGraph(graph),
+          searchPool(std::make_unique<ThreadPool>(SHORTEST_PATH_TREES)) {
     LOGI("RoutingEngine created");
 }
 
+RoutingEngine::~RoutingEngine() = default;
+
 std::vector<Route> RoutingEngine::calculateRoutes(const Location& start, const Location& end) {
     LOGI("Calculating route from (%.6f, %.6f) to (%.6f, %.6f)",
          start.latitude, start.longitude, end.latitude, end.longitude);
@@ -41,16 +50,24 @@ std::vector<Route> RoutingEngine::calculateRoutes(const Location& start, const L
 
     LOGI("Direct distance between points: %.1f meters", directDistance);
 
-    if (directDistance > MAX_ROUTE_DISTANCE) {
+    // The hierarchy answers long queries without exploring the whole graph; plain A* does not.
+    double maxDistance = roadGraph->getHierarchy() ? MAX_HIERARCHY_ROUTE_DISTANCE : MAX_ROUTE_DISTANCE;
+    if (directDistance > maxDistance) {
         LOGE("Distance exceeds maximum supported route distance (%.1f > %.1f)",
-             directDistance, MAX_ROUTE_DISTANCE);
+             directDistance, maxDistance);
 
         Route directRoute = createDirectRoute(start, end);
         return {directRoute};
     }
 
+    // Placing the endpoints splits segments and pins chain nodes, and the searches rely on that
+    // placement, so the whole calculation excludes every other reader and writer of the graph.
+    std::unique_lock<std::shared_mutex> lock(roadGraph->getMutex());
     Node* startNode = findNearestNode(start, NODE_SEARCH_RADIUS);
     Node* endNode = findNearestNode(end, NODE_SEARCH_RADIUS);
+    if (endNode) {
+        roadGraph->pinNode(endNode);
+    }
 
     if (!startNode || !endNode) {
         LOGE("Failed to find start or end node (null). Falling back to direct route.");
@@ -58,7 +75,25 @@ std::vector<Route> RoutingEngine::calculateRoutes(const Location& start, const L
         return {directRoute};
     }
 
+    // The alternative trees are plain Dijkstra searches, so they stay within the A* range. They
+    // belong to the calling thread, so concurrent calculations never share them.
+    ViaNodeAlternatives& alternativeTrees = ViaNodeAlternatives::forThread();
+    std::vector<std::future<void>> pending;
+    if (directDistance <= MAX_ROUTE_DISTANCE) {
+        pending = launchAlternatives(alternativeTrees, startNode, endNode);
+    }
+
+    // The fastest route cannot use the hierarchy either, so it is offered in the same range.
+    // It is searched here while the trees are still growing.
     std::vector<Node*> primaryPath = findPath(startNode, endNode);
+    std::vector<Node*> fastestPath;
+    if (!pending.empty() && !primaryPath.empty()) {
+        fastestPath = findFastestPath(startNode, endNode);
+    }
+    for (auto& tree : pending) {
+        tree.wait();
+    }
+
     if (primaryPath.empty()) {
         LOGE("Failed to find path via A*, falling back to direct route.");
         Route directRoute = createDirectRoute(start, end);
@@ -70,8 +105,16 @@ std::vector<Route> RoutingEngine::calculateRoutes(const Location& start, const L
     std::vector<Route> routes;
     routes.push_back(primaryRoute);
 
-    auto altRoutes = generateAlternatives(primaryRoute, start, end);
-    routes.insert(routes.end(), altRoutes.begin(), altRoutes.end());
+    if (!fastestPath.empty() && fastestPath != primaryPath) {
+        Route fastestRoute = createDetailedRoute(fastestPath, generateRouteId(), start, end);
+        fastestRoute.name = "Fastest Route";
+        routes.push_back(fastestRoute);
+    }
+
+    if (!pending.empty()) {
+        auto altRoutes = generateAlternatives(alternativeTrees, primaryPath, fastestPath, start, end);
+        routes.insert(routes.end(), altRoutes.begin(), altRoutes.end());
+    }
 
     LOGI("Generated %zu routes", routes.size());
     return routes;
@@ -377,73 +420,273 @@ double RoutingEngine::perpendicularDistance(const Location& point, const Locatio
 }
 
 std::vector<Node*> RoutingEngine::findPath(Node* start, Node* end) {
+    return findPathWithCost(start, end, ShortestCost());
+}
+
+std::vector<Node*> RoutingEngine::findFastestPath(Node* start, Node* end) {
+    const CompactGraph* graph = roadGraph->getCompactGraph();
+    if (!graph) {
+        return {};
+    }
+
+    if (maxSpeedLimit <= 0.0f || maxSpeedGeneration != roadGraph->getGeneration()) {
+        maxSpeedLimit = graph->findMaxSpeedLimit();
+        maxSpeedGeneration = roadGraph->getGeneration();
+    }
+    return findPathWithCost(start, end, FastestCost(maxSpeedLimit));
+}
+
+template <typename Cost>
+std::vector<Node*> RoutingEngine::findPathWithCost(Node* start, Node* end, const Cost& cost) {
 
     if (start == end) {
-        LOGI("A* findPath: start node == end node => single-node path");
+        LOGI("findPath: start node == end node => single-node path");
         return {start};
     }
 
-    std::priority_queue<NodeData, std::vector<NodeData>, std::greater<NodeData>> openSet;
-    std::unordered_set<Node*> closedSet;
-    std::unordered_map<Node*, Node*> cameFrom;
-    std::unordered_map<Node*, double> gScore;
+    const CompactGraph* graph = roadGraph->getCompactGraph();
+    if (!graph) {
+        LOGE("findPath: road graph has not been frozen");
+        return {};
+    }
 
-    openSet.push({ start, 0.0 });
-    gScore[start] = 0.0;
+    // The hierarchy's shortcuts are weighted by length, so other profiles always search directly.
+    if constexpr (Cost::USES_LENGTH) {
+        if (const ContractionHierarchy* hierarchy = roadGraph->getHierarchy()) {
+            std::vector<Node*> path = findHierarchyPath(*hierarchy, *graph, start, end);
+            if (!path.empty()) {
+                return path;
+            }
+            LOGD("Hierarchy query found no path, falling back to A*");
+        }
+    }
 
-    while (!openSet.empty()) {
-        NodeData current = openSet.top();
-        openSet.pop();
+    LengthBoundHeuristic heuristic(*graph, roadGraph->getLandmarks(), cost.minCostPerMeter());
+    SettledCounter visitor;
+    std::vector<Node*> path = searchBidirectional(*graph, start->index, end->index, cost, heuristic, visitor);
 
-        if (current.node == end) {
+    LOGD("Search settled %zu nodes", visitor.settled);
+    return path;
+}
 
-            std::vector<Node*> path;
-            Node* node = end;
-            while (node != start) {
-                path.push_back(node);
-                node = cameFrom[node];
-            }
-            path.push_back(start);
-            std::reverse(path.begin(), path.end());
-            return path;
+template <typename Cost, typename Heuristic, typename Visitor>
+std::vector<Node*> RoutingEngine::searchBidirectional(const CompactGraph& graph,
+                                                      uint32_t startIndex, uint32_t endIndex,
+                                                      const Cost& cost, const Heuristic& heuristic,
+                                                      Visitor& visitor) {
+
+    // Averaging the bounds towards the end and from the start gives both searches the same
+    // consistent reduced costs: forward keys are g + p, reverse keys are g - p.
+    auto potential = [&](uint32_t node) {
+        return 0.5 * (heuristic(node, endIndex) - heuristic(startIndex, node));
+    };
+
+    // Reverse steps store the successor towards the end in Step::previous.
+    SearchWorkspace* workspace[2] = { &SearchWorkspace::forThread(0), &SearchWorkspace::forThread(1) };
+    workspace[0]->reset(graph.getNodesCount());
+    workspace[1]->reset(graph.getNodesCount());
+    IndexedHeap* openSet[2] = { &workspace[0]->queue(), &workspace[1]->queue() };
+
+    double best = std::numeric_limits<double>::infinity();
+    uint32_t meeting = CompactGraph::INVALID_NODE;
+
+    auto label = [&](int side, uint32_t node, uint32_t from, uint32_t edgeId, double g) {
+        if (workspace[side]->distance(node) <= g) {
+            return false;
         }
+        workspace[side]->setDistance(node, g, {from, edgeId});
 
-        if (closedSet.find(current.node) != closedSet.end()) {
-            continue;
+        double opposite = workspace[1 - side]->distance(node);
+        if (g + opposite < best) {
+            best = g + opposite;
+            meeting = node;
         }
-        closedSet.insert(current.node);
+        return true;
+    };
 
-        for (RoadSegment* segment : current.node->segments) {
-            Node* neighbor = segment->end;
-            if (closedSet.find(neighbor) != closedSet.end()) {
+    auto push = [&](int side, uint32_t node, double g) {
+        double key = side == 0 ? g + potential(node) : g - potential(node);
+        openSet[side]->push(node, key);
+    };
+
+    struct ChainStep {
+        uint32_t previous;
+        uint32_t node;
+        uint32_t edge;
+        double g;
+    };
+    std::vector<ChainStep> chainSteps;
+
+    // The reverse search never enters chains, so once the forward search does, the route is
+    // forced up to the next junction and is followed there without queueing the interior nodes.
+    auto relaxForward = [&](uint32_t from, double g, const CompactGraph::Edge& edge, uint32_t edgeId) {
+        chainSteps.push_back({ from, edge.target, edgeId, g + cost(edge) });
+        while (!chainSteps.empty()) {
+            ChainStep step = chainSteps.back();
+            chainSteps.pop_back();
+
+            if (workspace[0]->isSettled(step.node) ||
+                !label(0, step.node, step.previous, step.edge, step.g)) {
                 continue;
             }
-            double tentativeG = gScore[current.node] + segment->length;
-            if (gScore.find(neighbor) == gScore.end() || tentativeG < gScore[neighbor]) {
-                cameFrom[neighbor] = current.node;
-                gScore[neighbor]   = tentativeG;
-                double heuristic   = estimateHeuristic(neighbor, end);
-                openSet.push({ neighbor, tentativeG + heuristic });
+
+            if (!graph.isChainInterior(step.node)) {
+                push(0, step.node, step.g);
+                continue;
             }
+
+            graph.forEachEdge(step.node, [&](const CompactGraph::Edge& next, uint32_t nextId) {
+                if (next.target != step.previous) {
+                    chainSteps.push_back({ step.node, next.target, nextId, step.g + cost(next) });
+                }
+            });
+        }
+    };
+
+    workspace[0]->setDistance(startIndex, 0.0, {});
+    workspace[1]->setDistance(endIndex, 0.0, {});
+    push(0, startIndex, 0.0);
+    push(1, endIndex, 0.0);
+
+    while (true) {
+        double forwardMin = openSet[0]->empty() ? std::numeric_limits<double>::infinity() : openSet[0]->top().key;
+        double backwardMin = openSet[1]->empty() ? std::numeric_limits<double>::infinity() : openSet[1]->top().key;
+        if (forwardMin + backwardMin >= best || (openSet[0]->empty() && openSet[1]->empty())) {
+            break;
+        }
+
+        int side = forwardMin <= backwardMin ? 0 : 1;
+        IndexedHeap::Entry current = openSet[side]->pop();
+
+        if (!workspace[side]->settle(current.node)) {
+            continue;
+        }
+
+        double currentG = workspace[side]->distance(current.node);
+        visitor.settle(current.node, currentG);
+
+        if (side == 0) {
+            graph.forEachEdge(current.node, [&](const CompactGraph::Edge& edge, uint32_t edgeId) {
+                relaxForward(current.node, currentG, edge, edgeId);
+            });
+        } else {
+            graph.forEachReverseEdge(current.node, [&](uint32_t source, const CompactGraph::Edge& edge, uint32_t edgeId) {
+                if (!workspace[1]->isSettled(source) &&
+                    label(1, source, current.node, edgeId, currentG + cost(edge))) {
+                    push(1, source, workspace[1]->distance(source));
+                }
+            });
         }
     }
 
-    return {};
+    if (meeting == CompactGraph::INVALID_NODE) {
+        return {};
+    }
+
+    std::vector<Node*> path = reconstructPath(graph, *workspace[0], startIndex, meeting);
+    for (uint32_t node = meeting; node != endIndex;) {
+        const SearchWorkspace::Step& step = workspace[1]->step(node);
+        graph.forEachViaNode(step.edge, [&](uint32_t via) {
+            path.push_back(roadGraph->getNodeByIndex(via));
+        });
+        path.push_back(roadGraph->getNodeByIndex(step.previous));
+        node = step.previous;
+    }
+
+    return path;
 }
 
-double RoutingEngine::estimateHeuristic(const Node* current, const Node* goal) {
+std::vector<Node*> RoutingEngine::findHierarchyPath(const ContractionHierarchy& hierarchy,
+                                                    const CompactGraph& graph,
+                                                    Node* start, Node* end) {
+    uint32_t baseCount = graph.getBaseNodesCount();
+    uint32_t startIndex = start->index;
+    uint32_t endIndex = end->index;
 
-    return roadGraph->haversineDistance(
-            current->latitude, current->longitude,
-            goal->latitude,    goal->longitude
-    );
+    // Projected endpoints are not part of the hierarchy; they enter it through their overlay edges.
+    std::vector<ContractionHierarchy::Seed> sources;
+    std::vector<ContractionHierarchy::Seed> targets;
+    double directLength = std::numeric_limits<double>::infinity();
+
+    if (startIndex < baseCount) {
+        sources.push_back({startIndex, 0.0});
+    } else {
+        graph.forEachEdge(startIndex, [&](const CompactGraph::Edge& edge, uint32_t) {
+            if (edge.target == endIndex) {
+                directLength = std::min(directLength, static_cast<double>(edge.length));
+            } else if (edge.target < baseCount) {
+                sources.push_back({edge.target, edge.length});
+            }
+        });
+    }
+
+    if (endIndex < baseCount) {
+        targets.push_back({endIndex, 0.0});
+    } else {
+        graph.forEachOverlayEdgeInto(endIndex, [&](uint32_t source, const CompactGraph::Edge& edge, uint32_t) {
+            if (source == startIndex) {
+                directLength = std::min(directLength, static_cast<double>(edge.length));
+            } else if (source < baseCount) {
+                targets.push_back({source, edge.length});
+            }
+        });
+    }
+
+    std::vector<uint32_t> indices;
+    double distance = 0.0;
+    bool found = hierarchy.findPath(sources, targets, indices, distance);
+
+    if (!found || directLength <= distance) {
+        if (directLength == std::numeric_limits<double>::infinity()) {
+            return {};
+        }
+        return {start, end};
+    }
+
+    std::vector<Node*> path;
+    path.reserve(indices.size() + 2);
+    if (indices.front() != startIndex) {
+        path.push_back(start);
+    }
+    for (uint32_t index : indices) {
+        path.push_back(roadGraph->getNodeByIndex(index));
+    }
+    if (indices.back() != endIndex) {
+        path.push_back(end);
+    }
+
+    LOGD("Hierarchy path with %zu nodes, %.1f meters", path.size(), distance);
+    return path;
+}
+
+std::vector<Node*> RoutingEngine::reconstructPath(const CompactGraph& graph,
+                                                  const SearchWorkspace& workspace,
+                                                  uint32_t start, uint32_t end) {
+    std::vector<const SearchWorkspace::Step*> steps;
+    uint32_t node = end;
+    while (node != start) {
+        const SearchWorkspace::Step& step = workspace.step(node);
+        steps.push_back(&step);
+        node = step.previous;
+    }
+
+    std::vector<Node*> path;
+    path.push_back(roadGraph->getNodeByIndex(start));
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+        graph.forEachViaNode((*it)->edge, [&](uint32_t via) {
+            path.push_back(roadGraph->getNodeByIndex(via));
+        });
+        uint32_t target = (it + 1 != steps.rend()) ? (*(it + 1))->previous : end;
+        path.push_back(roadGraph->getNodeByIndex(target));
+    }
+    return path;
 }
 
 std::string RoutingEngine::generateRouteId() {
 
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
+    // Alternatives are built on worker threads, so each thread keeps its own generator.
+    thread_local std::mt19937 gen(std::random_device{}());
+    thread_local std::uniform_int_distribution<> dis(0, 15);
     static const char* digits = "0123456789abcdef";
 
     std::string uuid = "route-";
@@ -457,7 +700,8 @@ Node* RoutingEngine::findNearestNode(const Location& location, double searchRadi
     LOGD("findNearestNode: location=(%.6f, %.6f). Searching up to %.1f meters.",
          location.latitude, location.longitude, searchRadius);
 
-    std::vector<RoadSegment*> nearbyRoads = roadGraph->findNearbyRoads(location, searchRadius);
+    std::vector<RoadSegment*> nearbyRoads;
+    roadGraph->findNearestRoads(location, NEAREST_SEGMENT_CANDIDATES, searchRadius, nearbyRoads);
 
     LOGD("findNearestNode: found %zu roads within %.1f meters", nearbyRoads.size(), searchRadius);
 
@@ -519,14 +763,13 @@ Node* RoutingEngine::findNearestNode(const Location& location, double searchRadi
 
             if (distToStart > MIN_NODE_SPACING && distToEnd > MIN_NODE_SPACING) {
 
-                std::string nodeId = "projected_" + std::to_string(segment->id) + "_" +
-                                     std::to_string(static_cast<int>(projected.latitude * 1000000)) + "_" +
-                                     std::to_string(static_cast<int>(projected.longitude * 1000000));
-
-                Node* newNode = roadGraph->addNode(nodeId, projected.latitude, projected.longitude);
+                Node* newNode = findSplitNode(segment, projected, MIN_NODE_SPACING);
+                if (!newNode) {
+                    newNode = roadGraph->addSyntheticNode(projected.latitude, projected.longitude);
 
-                roadGraph->addSegment(segment->start, newNode, segment->name, segment->speedLimit, segment->type);
-                roadGraph->addSegment(newNode, segment->end, segment->name, segment->speedLimit, segment->type);
+                    roadGraph->addSegment(segment->start, newNode, segment->name, segment->speedLimit, segment->type);
+                    roadGraph->addSegment(newNode, segment->end, segment->name, segment->speedLimit, segment->type);
+                }
 
                 minDistance = distance;
                 nearest = newNode;
@@ -542,6 +785,32 @@ Node* RoutingEngine::findNearestNode(const Location& location, double searchRadi
     return nearest;
 }
 
+Node* RoutingEngine::findSplitNode(RoadSegment* segment, const Location& projected, double maxDistance) {
+    // Split segments are not spatially indexed, so an earlier split is found through the adjacency
+    // of the segment it divided. Reusing it keeps reroutes to the same destination from growing the graph.
+    for (RoadSegment* first : segment->start->segments) {
+        Node* splitNode = first->end;
+        if (!RoadGraph::isSyntheticId(splitNode->id)) {
+            continue;
+        }
+
+        double distance = roadGraph->haversineDistance(
+                projected.latitude, projected.longitude,
+                splitNode->latitude, splitNode->longitude
+        );
+        if (distance > maxDistance) {
+            continue;
+        }
+
+        for (RoadSegment* second : splitNode->segments) {
+            if (second->end == segment->end) {
+                return splitNode;
+            }
+        }
+    }
+    return nullptr;
+}
+
 Location RoutingEngine::projectLocationOntoSegment(const Location& loc, RoadSegment* segment) {
 
     double x1 = segment->start->longitude;
@@ -571,266 +840,60 @@ Location RoutingEngine::projectLocationOntoSegment(const Location& loc, RoadSegm
     return Location{projY, projX, static_cast<float>(bearing), 0};
 }
 
-std::vector<Route> RoutingEngine::generateAlternatives(const Route& primaryRoute,
+std::vector<std::future<void>> RoutingEngine::launchAlternatives(ViaNodeAlternatives& trees,
+                                                                 Node* startNode, Node* endNode) {
+    const CompactGraph* graph = roadGraph->getCompactGraph();
+    if (!graph || startNode == endNode) {
+        return {};
+    }
+
+    // The trees only read the graph and each owns its workspace, so they grow side by side.
+    uint32_t startIndex = startNode->index;
+    uint32_t endIndex = endNode->index;
+    std::vector<std::future<void>> pending;
+    pending.push_back(searchPool->submit([&trees, graph, startIndex, endIndex]() {
+        trees.growForward(*graph, startIndex, endIndex);
+    }));
+    pending.push_back(searchPool->submit([&trees, graph, startIndex, endIndex]() {
+        trees.growBackward(*graph, startIndex, endIndex);
+    }));
+    return pending;
+}
+
+std::vector<Route> RoutingEngine::generateAlternatives(ViaNodeAlternatives& trees,
+                                                       const std::vector<Node*>& primaryPath,
+                                                       const std::vector<Node*>& fastestPath,
                                                        const Location& start,
                                                        const Location& end) {
 
     std::vector<Route> alternatives;
 
-    if (primaryRoute.points.size() < 2) {
-        LOGI("Route has too few points to generate alternatives");
-        return alternatives;
-    }
-
-    Node* startNode = findNearestNode(start);
-    Node* endNode = findNearestNode(end);
-
-    if (!startNode || !endNode) {
-        LOGE("Failed to find start or end node for alternatives");
-        return alternatives;
-    }
-
-    Route fastRoute = generateFastRoute(startNode, endNode, start, end);
-    if (!fastRoute.points.empty() && isRouteDifferentEnough(fastRoute, primaryRoute)) {
-        fastRoute.name = "Fastest Route";
-        alternatives.push_back(fastRoute);
+    std::vector<uint32_t> primary;
+    primary.reserve(primaryPath.size());
+    for (Node* node : primaryPath) {
+        primary.push_back(node->index);
     }
 
-    Route noHighwaysRoute = generateNoHighwaysRoute(startNode, endNode, start, end);
-    if (!noHighwaysRoute.points.empty() && isRouteDifferentEnough(noHighwaysRoute, primaryRoute)) {
-        noHighwaysRoute.name = "No Highways";
-        alternatives.push_back(noHighwaysRoute);
-    }
+    std::vector<std::vector<uint32_t>> viaPaths = trees.select(
+            *roadGraph->getCompactGraph(), primary.front(), primary.back(), primary, MAX_ALTERNATIVES);
 
-    LOGI("Generated %zu alternative routes", alternatives.size());
-    return alternatives;
-}
-
-Route RoutingEngine::generateFastRoute(Node* start, Node* end,
-                                       const Location& startLoc,
-                                       const Location& endLoc) {
-    LOGI("Generating fast route");
-
-    auto speedCostFunction = [](RoadSegment* segment) -> double {
-
-        double speedFactor = 50.0 / segment->speedLimit;
-        return segment->length * speedFactor;
-    };
-
-    std::vector<Node*> path = findPathWithCostFunction(start, end, speedCostFunction);
-
-    if (path.empty()) {
-        LOGE("Failed to find fast route path");
-        return Route();
-    }
-
-    Route route = createDetailedRoute(path, generateRouteId(), startLoc, endLoc);
-    route.name = "Fastest Route";
-
-    route.durationSeconds = calculateCustomDuration(route, 1.2);
-
-    return route;
-}
-
-Route RoutingEngine::generateNoHighwaysRoute(Node* start, Node* end,
-                                             const Location& startLoc,
-                                             const Location& endLoc) {
-    LOGI("Generating no-highways route");
-
-    auto noHighwaysCostFunction = [](RoadSegment* segment) -> double {
-        double baseCost = segment->length;
-
-        if (segment->type == RoadType::HIGHWAY) {
-            return baseCost * 10.0;
-        }
-
-        return baseCost;
-    };
-
-    std::vector<Node*> path = findPathWithCostFunction(start, end, noHighwaysCostFunction);
-
-    if (path.empty()) {
-        LOGE("Failed to find no-highways route path");
-        return Route();
-    }
-
-    Route route = createDetailedRoute(path, generateRouteId(), startLoc, endLoc);
-    route.name = "No Highways";
-
-    route.durationSeconds = calculateCustomDuration(route, 0.8);
-
-    return route;
-}
-
-std::vector<Node*> RoutingEngine::findPathWithCostFunction(
-        Node* start, Node* end,
-        std::function<double(RoadSegment*)> costFunction) {
-
-    if (start == end) {
-        return {start};
-    }
-
-    std::priority_queue<NodeData, std::vector<NodeData>, std::greater<NodeData>> openSet;
-    std::unordered_set<Node*> closedSet;
-    std::unordered_map<Node*, Node*> cameFrom;
-    std::unordered_map<Node*, double> gScore;
-
-    openSet.push({ start, 0.0 });
-    gScore[start] = 0.0;
-
-    while (!openSet.empty()) {
-        NodeData current = openSet.top();
-        openSet.pop();
-
-        if (current.node == end) {
-
-            std::vector<Node*> path;
-            Node* node = end;
-            while (node != start) {
-                path.push_back(node);
-                node = cameFrom[node];
-            }
-            path.push_back(start);
-            std::reverse(path.begin(), path.end());
-            return path;
+    for (const std::vector<uint32_t>& viaPath : viaPaths) {
+        std::vector<Node*> path;
+        path.reserve(viaPath.size());
+        for (uint32_t index : viaPath) {
+            path.push_back(roadGraph->getNodeByIndex(index));
         }
-
-        if (closedSet.find(current.node) != closedSet.end()) {
+        if (path == fastestPath) {
             continue;
         }
-        closedSet.insert(current.node);
-
-        for (RoadSegment* segment : current.node->segments) {
-            Node* neighbor = segment->end;
-            if (closedSet.find(neighbor) != closedSet.end()) {
-                continue;
-            }
-
-            double segmentCost = costFunction(segment);
-            double tentativeG = gScore[current.node] + segmentCost;
-
-            if (gScore.find(neighbor) == gScore.end() || tentativeG < gScore[neighbor]) {
-                cameFrom[neighbor] = current.node;
-                gScore[neighbor] = tentativeG;
-                double heuristic = estimateHeuristic(neighbor, end);
-                openSet.push({ neighbor, tentativeG + heuristic });
-            }
-        }
-    }
-
-    return {};
-}
-
-int RoutingEngine::calculateCustomDuration(const Route& route, double speedFactor) {
-
-    double totalDistance = 0.0;
-    for (size_t i = 1; i < route.points.size(); ++i) {
-        const Location& p1 = route.points[i - 1];
-        const Location& p2 = route.points[i];
-        totalDistance += roadGraph->haversineDistance(p1.latitude, p1.longitude,
-                                                      p2.latitude, p2.longitude);
-    }
-
-    double avgSpeed = 9.72 * speedFactor;
-    int durationSec = static_cast<int>(totalDistance / avgSpeed);
-    return durationSec;
-}
-
-bool RoutingEngine::isRouteDifferentEnough(const Route& route1, const Route& route2) {
-
-    if (route1.points.size() < 2 || route2.points.size() < 2) {
-        return false;
-    }
-
-    const Location& start1 = route1.points.front();
-    const Location& end1 = route1.points.back();
-    const Location& start2 = route2.points.front();
-    const Location& end2 = route2.points.back();
-
-    double startDist = roadGraph->haversineDistance(start1.latitude, start1.longitude,
-                                                    start2.latitude, start2.longitude);
-    double endDist = roadGraph->haversineDistance(end1.latitude, end1.longitude,
-                                                  end2.latitude, end2.longitude);
-
-    if (startDist > 100.0 || endDist > 100.0) {
-        return false;
-    }
-
-    int sharedPoints = 0;
-    int totalPoints = 0;
-
-    const int sampleCount = 10;
-
-    for (int i = 0; i < sampleCount; i++) {
-        double t = static_cast<double>(i) / (sampleCount - 1);
-
-        Location p1 = getRoutePointAtFraction(route1, t);
-        Location p2 = getRoutePointAtFraction(route2, t);
-
-        double dist = roadGraph->haversineDistance(p1.latitude, p1.longitude,
-                                                   p2.latitude, p2.longitude);
-
-        if (dist < 200.0) {
-            sharedPoints++;
-        }
-        totalPoints++;
-    }
 
-    double similarity = static_cast<double>(sharedPoints) / totalPoints;
-
-    return similarity < 0.7;
-}
-
-Location RoutingEngine::getRoutePointAtFraction(const Route& route, double fraction) {
-
-    if (route.points.empty()) {
-        return Location{0, 0, 0, 0};
-    }
-
-    if (route.points.size() == 1 || fraction <= 0.0) {
-        return route.points.front();
-    }
-
-    if (fraction >= 1.0) {
-        return route.points.back();
-    }
-
-    std::vector<double> cumDistances;
-    cumDistances.push_back(0.0);
-
-    for (size_t i = 1; i < route.points.size(); i++) {
-        const Location& p1 = route.points[i-1];
-        const Location& p2 = route.points[i];
-
-        double segmentDist = roadGraph->haversineDistance(p1.latitude, p1.longitude,
-                                                          p2.latitude, p2.longitude);
-        cumDistances.push_back(cumDistances.back() + segmentDist);
+        Route route = createDetailedRoute(path, generateRouteId(), start, end);
+        route.name = "Alternative Route " + std::to_string(alternatives.size() + 1);
+        alternatives.push_back(route);
     }
 
-    double totalDistance = cumDistances.back();
-    double targetDistance = totalDistance * fraction;
-
-    for (size_t i = 1; i < cumDistances.size(); i++) {
-        if (cumDistances[i] >= targetDistance) {
-
-            const Location& p1 = route.points[i-1];
-            const Location& p2 = route.points[i];
-
-            double segmentDist = cumDistances[i] - cumDistances[i-1];
-            double segmentFraction = (targetDistance - cumDistances[i-1]) / segmentDist;
-
-            double lat = p1.latitude + segmentFraction * (p2.latitude - p1.latitude);
-            double lon = p1.longitude + segmentFraction * (p2.longitude - p1.longitude);
-
-            double bearing = p1.bearing + segmentFraction * (p2.bearing - p1.bearing);
-
-            float speed = p1.speed + segmentFraction * (p2.speed - p1.speed);
-
-            return Location{lat, lon, static_cast<float>(bearing), speed};
-        }
-    }
-
-    return route.points.back();
+    LOGI("Generated %zu alternative routes", alternatives.size());
+    return alternatives;
 }
 
 int RoutingEngine::calculateRouteDuration(const Route& route) {
@@ -7,29 +7,35 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 #include <vector>
 #include <string>
-#include <functional>
 #include "road_graph.h"
+#include "compact_graph.h"
 #include "route_matcher.h"
+#include "search_policies.h"
+#include "search_workspace.h"
+
+class ContractionHierarchy;
+class ThreadPool;
+class ViaNodeAlternatives;
 
 class RoutingEngine {
 public:
     explicit RoutingEngine(RoadGraph* graph);
+    ~RoutingEngine();
 
     std::vector<Route> calculateRoutes(const Location& start, const Location& end);
 
 private:
     RoadGraph* roadGraph;
+    // The alternative-route trees grow here while the caller computes the primary route.
+    std::unique_ptr<ThreadPool> searchPool;
 
-    struct NodeData {
-        Node* node;
-        double fScore;
-        bool operator>(const NodeData& other) const {
-            return fScore > other.fScore;
-        }
-    };
+    // Highest speed limit in the graph, found again after each reload for the fastest route's heuristic.
+    float maxSpeedLimit = 0.0f;
+    uint64_t maxSpeedGeneration = 0;
 
     void addIntermediatePoints(std::vector<Location>& points,
                                const Location& start,
@@ -44,40 +50,46 @@ private:
 
     std::vector<Node*> findPath(Node* start, Node* end);
 
+    // Minimum travel time at the speed limits; always an A* search, never the hierarchy.
+    std::vector<Node*> findFastestPath(Node* start, Node* end);
+
+    template <typename Cost>
+    std::vector<Node*> findPathWithCost(Node* start, Node* end, const Cost& cost);
+
+    // Search kernel shared by every cost profile; the heuristic must be a consistent lower bound.
+    template <typename Cost, typename Heuristic, typename Visitor>
+    std::vector<Node*> searchBidirectional(const CompactGraph& graph, uint32_t startIndex, uint32_t endIndex,
+                                           const Cost& cost, const Heuristic& heuristic, Visitor& visitor);
+
+    std::vector<Node*> findHierarchyPath(const ContractionHierarchy& hierarchy, const CompactGraph& graph,
+                                         Node* start, Node* end);
+
+    std::vector<Node*> reconstructPath(const CompactGraph& graph,
+                                       const SearchWorkspace& workspace,
+                                       uint32_t start, uint32_t end);
+
     Route createDetailedRoute(const std::vector<Node*>& path, const std::string& id,
                               const Location& start, const Location& end);
 
     Route createDirectRoute(const Location& start, const Location& end);
 
-    double estimateHeuristic(const Node* current, const Node* goal);
-
     std::string generateRouteId();
 
     Node* findNearestNode(const Location& location, double searchRadius = 5000.0);
 
-    std::vector<Route> generateAlternatives(const Route& primaryRoute,
-                                            const Location& start,
-                                            const Location& end);
-
-    Route generateFastRoute(Node* start, Node* end,
-                            const Location& startLoc,
-                            const Location& endLoc);
-
-    Route generateNoHighwaysRoute(Node* start, Node* end,
-                                  const Location& startLoc,
-                                  const Location& endLoc);
+    // A node that an earlier route placed on `segment` within `maxDistance` of `projected`, if any.
+    Node* findSplitNode(RoadSegment* segment, const Location& projected, double maxDistance);
 
-    std::vector<Node*> findPathWithCostFunction(
-            Node* start,
-            Node* end,
-            std::function<double(RoadSegment*)> costFunction);
+    std::vector<std::future<void>> launchAlternatives(ViaNodeAlternatives& trees, Node* startNode, Node* endNode);
 
-    bool isRouteDifferentEnough(const Route& route1, const Route& route2);
-
-    Location getRoutePointAtFraction(const Route& route, double fraction);
+    // Via-node alternatives to the shortest route, skipping one identical to the fastest route.
+    std::vector<Route> generateAlternatives(ViaNodeAlternatives& trees,
+                                            const std::vector<Node*>& primaryPath,
+                                            const std::vector<Node*>& fastestPath,
+                                            const Location& start,
+                                            const Location& end);
 
     int calculateRouteDuration(const Route& route);
-    int calculateCustomDuration(const Route& route, double speedFactor);
 
     Location projectLocationOntoSegment(const Location& loc, RoadSegment* segment);
 
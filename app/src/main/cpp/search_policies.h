@@ -0,0 +1,78 @@
+/*
+ * File: search_policies.h
+ * Description: Cost, heuristic and visitor policies plugged into the RoutingEngine search kernels at compile time.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "compact_graph.h"
+#include "landmark_index.h"
+#include "road_graph.h"
+
+// A cost profile maps an edge to its traversal cost and bounds the cost of one meter of road,
+// which keeps length-based heuristics admissible. Profiles whose cost is the edge length can be
+// answered by the contraction hierarchy.
+
+struct ShortestCost {
+    static constexpr bool USES_LENGTH = true;
+
+    double operator()(const CompactGraph::Edge& edge) const { return edge.length; }
+
+    double minCostPerMeter() const { return 1.0; }
+};
+
+// Travel time in seconds at the speed limit. Implausibly low limits are raised to MIN_SPEED.
+class FastestCost {
+public:
+    static constexpr bool USES_LENGTH = false;
+    static constexpr double MIN_SPEED = 5.0;
+
+    // `maxSpeedLimit` is the highest limit in the graph: the cheapest meter is driven at it.
+    explicit FastestCost(double maxSpeedLimit) : maxSpeedLimit(std::max(maxSpeedLimit, MIN_SPEED)) {}
+
+    double operator()(const CompactGraph::Edge& edge) const {
+        return edge.length * KMH_TO_SECONDS_PER_METER / std::max(static_cast<double>(edge.speedLimit), MIN_SPEED);
+    }
+
+    double minCostPerMeter() const { return KMH_TO_SECONDS_PER_METER / maxSpeedLimit; }
+
+private:
+    static constexpr double KMH_TO_SECONDS_PER_METER = 3.6;
+
+    double maxSpeedLimit;
+};
+
+// Lower bound on the cost from one node to another: the larger of the straight-line and
+// landmark bounds on length, scaled to the cost profile. Both bounds are consistent, so their
+// maximum is too.
+class LengthBoundHeuristic {
+public:
+    LengthBoundHeuristic(const CompactGraph& graph, const LandmarkIndex* landmarks, double costPerMeter)
+            : graph(graph), landmarks(landmarks), costPerMeter(costPerMeter) {}
+
+    double operator()(uint32_t from, uint32_t to) const {
+        double bound = RoadGraph::haversineDistance(graph.latitude(from), graph.longitude(from),
+                                                    graph.latitude(to), graph.longitude(to));
+        if (landmarks) {
+            bound = std::max(bound, landmarks->lowerBound(graph, from, to));
+        }
+        return costPerMeter * bound;
+    }
+
+private:
+    const CompactGraph& graph;
+    const LandmarkIndex* landmarks;
+    double costPerMeter;
+};
+
+// Visitors observe every node a search settles.
+struct SettledCounter {
+    size_t settled = 0;
+
+    void settle(uint32_t, double) { settled++; }
+};
@@ -0,0 +1,82 @@
+/*
+ * File: search_workspace.h
+ * Description: Header file for the SearchWorkspace class, reusable per-thread shortest-path labels indexed by node id.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "indexed_heap.h"
+
+// Labels are stamped with the generation of the query that wrote them, so starting a new
+// query only bumps the generation instead of clearing arrays sized to the whole graph.
+// The open set lives here too, so its storage is reused across queries.
+class SearchWorkspace {
+public:
+    struct Step {
+        uint32_t previous;
+        uint32_t edge;
+    };
+
+    // Per-thread workspaces; a bidirectional search uses one slot per direction.
+    static SearchWorkspace& forThread(size_t slot = 0) {
+        thread_local SearchWorkspace workspaces[2];
+        return workspaces[slot];
+    }
+
+    void reset(size_t nodeCount) {
+        if (labels.size() < nodeCount) {
+            labels.resize(nodeCount);
+        }
+        openSet.reset(nodeCount);
+        if (++generation == 0) {
+            std::fill(labels.begin(), labels.end(), Label());
+            generation = 1;
+        }
+    }
+
+    bool isReached(uint32_t node) const { return labels[node].reached == generation; }
+    bool isSettled(uint32_t node) const { return labels[node].settled == generation; }
+
+    double distance(uint32_t node) const {
+        return isReached(node) ? labels[node].distance : std::numeric_limits<double>::infinity();
+    }
+
+    const Step& step(uint32_t node) const { return labels[node].step; }
+
+    IndexedHeap& queue() { return openSet; }
+
+    void setDistance(uint32_t node, double distance, Step step) {
+        Label& label = labels[node];
+        label.reached = generation;
+        label.distance = distance;
+        label.step = step;
+    }
+
+    // Returns false when the node was already settled by this query.
+    bool settle(uint32_t node) {
+        if (labels[node].settled == generation) {
+            return false;
+        }
+        labels[node].settled = generation;
+        return true;
+    }
+
+private:
+    struct Label {
+        uint32_t reached = 0;
+        uint32_t settled = 0;
+        double distance = 0.0;
+        Step step{};
+    };
+
+    std::vector<Label> labels;
+    IndexedHeap openSet;
+    uint32_t generation = 0;
+};
@@ -0,0 +1,262 @@
+/*
+ * File: segment_rtree.cpp
+ * Description: Implementation of the SegmentRTree class, responsible for Hilbert-packed bulk loading and nearest-segment queries.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "segment_rtree.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define LOG_TAG "SegmentRTree"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr double METERS_PER_DEGREE = 6371000.0 * M_PI / 180.0;
+constexpr uint32_t HILBERT_ORDER = 1u << 16;
+
+uint32_t hilbertIndex(uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+    for (uint32_t s = HILBERT_ORDER / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0 ? 1 : 0;
+        uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+
+        if (ry == 0) {
+            if (rx == 1) {
+                x = HILBERT_ORDER - 1 - x;
+                y = HILBERT_ORDER - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+double metersPerDegreeLon(double lat) {
+    return METERS_PER_DEGREE * std::cos(lat * M_PI / 180.0);
+}
+
+}
+
+void SegmentRTree::build(const std::vector<RoadSegment*>& segments) {
+    boxes.assign({});
+    firstChild.assign({});
+    levelEnds.clear();
+    items.clear();
+    backingStorage.reset();
+
+    if (segments.empty()) {
+        return;
+    }
+
+    size_t count = segments.size();
+    std::vector<Box> segmentBoxes(count);
+    Box extent = boxOf(segments[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        segmentBoxes[i] = boxOf(segments[i]);
+        extent.minLat = std::min(extent.minLat, segmentBoxes[i].minLat);
+        extent.minLon = std::min(extent.minLon, segmentBoxes[i].minLon);
+        extent.maxLat = std::max(extent.maxLat, segmentBoxes[i].maxLat);
+        extent.maxLon = std::max(extent.maxLon, segmentBoxes[i].maxLon);
+    }
+
+    double latSpan = std::max(extent.maxLat - extent.minLat, 1e-9);
+    double lonSpan = std::max(extent.maxLon - extent.minLon, 1e-9);
+
+    std::vector<std::pair<uint32_t, uint32_t>> order(count);
+    for (size_t i = 0; i < count; i++) {
+        const Box& box = segmentBoxes[i];
+        double centerLat = (box.minLat + box.maxLat) / 2.0;
+        double centerLon = (box.minLon + box.maxLon) / 2.0;
+        auto x = static_cast<uint32_t>((HILBERT_ORDER - 1) * (centerLon - extent.minLon) / lonSpan);
+        auto y = static_cast<uint32_t>((HILBERT_ORDER - 1) * (centerLat - extent.minLat) / latSpan);
+        order[i] = {hilbertIndex(x, y), static_cast<uint32_t>(i)};
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<Box> packedBoxes;
+    std::vector<uint32_t> packedChildren;
+    items.reserve(count);
+    packedBoxes.reserve(count + count / (NODE_CAPACITY - 1) + 1);
+    packedChildren.reserve(packedBoxes.capacity());
+
+    for (const auto& entry : order) {
+        packedChildren.push_back(static_cast<uint32_t>(items.size()));
+        items.push_back(segments[entry.second]);
+        packedBoxes.push_back(segmentBoxes[entry.second]);
+    }
+    levelEnds.push_back(packedBoxes.size());
+
+    size_t levelStart = 0;
+    while (levelEnds.back() - levelStart > 1) {
+        size_t levelEnd = levelEnds.back();
+
+        for (size_t position = levelStart; position < levelEnd; position += NODE_CAPACITY) {
+            size_t childEnd = std::min(position + NODE_CAPACITY, levelEnd);
+            Box parent = packedBoxes[position];
+            for (size_t child = position + 1; child < childEnd; child++) {
+                parent.minLat = std::min(parent.minLat, packedBoxes[child].minLat);
+                parent.minLon = std::min(parent.minLon, packedBoxes[child].minLon);
+                parent.maxLat = std::max(parent.maxLat, packedBoxes[child].maxLat);
+                parent.maxLon = std::max(parent.maxLon, packedBoxes[child].maxLon);
+            }
+            packedBoxes.push_back(parent);
+            packedChildren.push_back(static_cast<uint32_t>(position));
+        }
+
+        levelStart = levelEnd;
+        levelEnds.push_back(packedBoxes.size());
+    }
+
+    boxes.assign(std::move(packedBoxes));
+    firstChild.assign(std::move(packedChildren));
+
+    LOGI("Built segment R-tree with %zu segments in %zu levels", count, levelEnds.size());
+}
+
+void SegmentRTree::attach(const Box* boxData, const uint32_t* childData, size_t boxCount,
+                          std::vector<size_t> levels, std::vector<RoadSegment*> leafSegments,
+                          std::shared_ptr<const void> storage) {
+    boxes.attach(boxData, boxCount);
+    firstChild.attach(childData, boxCount);
+    levelEnds = std::move(levels);
+    items = std::move(leafSegments);
+    backingStorage = std::move(storage);
+
+    LOGI("Attached segment R-tree with %zu segments in %zu levels", items.size(), levelEnds.size());
+}
+
+void SegmentRTree::findNearest(double lat, double lon, size_t k, double maxDistanceMeters,
+                               std::vector<RoadSegment*>& result) const {
+    result.clear();
+    if (k == 0) {
+        return;
+    }
+
+    struct Candidate {
+        double distance;
+        size_t position;
+        RoadSegment* segment;
+    };
+
+    auto fartherFirst = [](const Candidate& a, const Candidate& b) {
+        return a.distance > b.distance;
+    };
+
+    thread_local std::vector<Candidate> queue;
+    queue.clear();
+
+    double lonScale = metersPerDegreeLon(lat);
+
+    auto push = [&](const Candidate& candidate) {
+        if (candidate.distance <= maxDistanceMeters) {
+            queue.push_back(candidate);
+            std::push_heap(queue.begin(), queue.end(), fartherFirst);
+        }
+    };
+
+    if (!boxes.empty()) {
+        size_t root = boxes.size() - 1;
+        if (root < levelEnds[0]) {
+            push({segmentDistance(lat, lon, lonScale, items[root]), root, items[root]});
+        } else {
+            push({distanceToBox(lat, lon, lonScale, boxes[root]), root, nullptr});
+        }
+    }
+
+    while (!queue.empty() && result.size() < k) {
+        std::pop_heap(queue.begin(), queue.end(), fartherFirst);
+        Candidate current = queue.back();
+        queue.pop_back();
+
+        if (current.segment) {
+            result.push_back(current.segment);
+            continue;
+        }
+
+        size_t first = firstChild[current.position];
+        size_t end = std::min(first + NODE_CAPACITY, levelEndFor(first));
+        bool leafLevel = first < levelEnds[0];
+
+        for (size_t child = first; child < end; child++) {
+            if (leafLevel) {
+                push({segmentDistance(lat, lon, lonScale, items[child]), child, items[child]});
+            } else {
+                push({distanceToBox(lat, lon, lonScale, boxes[child]), child, nullptr});
+            }
+        }
+    }
+
+    LOGD("R-tree query returned %zu segments", result.size());
+}
+
+void SegmentRTree::findWithinRadius(double lat, double lon, double radiusMeters,
+                                    std::vector<RoadSegment*>& result) const {
+    findNearest(lat, lon, std::numeric_limits<size_t>::max(), radiusMeters, result);
+}
+
+size_t SegmentRTree::levelEndFor(size_t position) const {
+    for (size_t levelEnd : levelEnds) {
+        if (position < levelEnd) {
+            return levelEnd;
+        }
+    }
+    return boxes.size();
+}
+
+SegmentRTree::Box SegmentRTree::boxOf(const RoadSegment* segment) {
+    return Box{
+            std::min(segment->start->latitude, segment->end->latitude),
+            std::min(segment->start->longitude, segment->end->longitude),
+            std::max(segment->start->latitude, segment->end->latitude),
+            std::max(segment->start->longitude, segment->end->longitude)
+    };
+}
+
+double SegmentRTree::distanceToBox(double lat, double lon, double metersPerDegreeLon, const Box& box) {
+    double dLat = 0.0;
+    if (lat < box.minLat) {
+        dLat = box.minLat - lat;
+    } else if (lat > box.maxLat) {
+        dLat = lat - box.maxLat;
+    }
+
+    double dLon = 0.0;
+    if (lon < box.minLon) {
+        dLon = box.minLon - lon;
+    } else if (lon > box.maxLon) {
+        dLon = lon - box.maxLon;
+    }
+
+    double dy = dLat * METERS_PER_DEGREE;
+    double dx = dLon * metersPerDegreeLon;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+double SegmentRTree::segmentDistance(double lat, double lon, double metersPerDegreeLon,
+                                     const RoadSegment* segment) {
+    double ax = (segment->start->longitude - lon) * metersPerDegreeLon;
+    double ay = (segment->start->latitude - lat) * METERS_PER_DEGREE;
+    double bx = (segment->end->longitude - lon) * metersPerDegreeLon;
+    double by = (segment->end->latitude - lat) * METERS_PER_DEGREE;
+
+    double dx = bx - ax;
+    double dy = by - ay;
+    double lengthSquared = dx * dx + dy * dy;
+
+    double t = 0.0;
+    if (lengthSquared > 0.0) {
+        t = std::max(0.0, std::min(1.0, -(ax * dx + ay * dy) / lengthSquared));
+    }
+
+    double px = ax + t * dx;
+    double py = ay + t * dy;
+    return std::sqrt(px * px + py * py);
+}
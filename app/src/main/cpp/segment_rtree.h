@@ -0,0 +1,59 @@
+/*
+ * File: segment_rtree.h
+ * Description: Header file for the SegmentRTree class, a bulk-loaded packed R-tree over road segment bounding boxes.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "packed_array.h"
+#include "road_graph.h"
+
+class SegmentRTree {
+public:
+    struct Box {
+        double minLat;
+        double minLon;
+        double maxLat;
+        double maxLon;
+    };
+
+    SegmentRTree() = default;
+
+    void build(const std::vector<RoadSegment*>& segments);
+
+    void attach(const Box* boxData, const uint32_t* childData, size_t boxCount,
+                std::vector<size_t> levels, std::vector<RoadSegment*> leafSegments,
+                std::shared_ptr<const void> storage);
+
+    void findNearest(double lat, double lon, size_t k, double maxDistanceMeters,
+                     std::vector<RoadSegment*>& result) const;
+
+    void findWithinRadius(double lat, double lon, double radiusMeters,
+                          std::vector<RoadSegment*>& result) const;
+
+    size_t size() const { return items.size(); }
+
+private:
+    friend class GraphSnapshot;
+
+    static constexpr size_t NODE_CAPACITY = 16;
+
+    // Leaf boxes come first in Hilbert order, followed by each parent level.
+    PackedArray<Box> boxes;
+    PackedArray<uint32_t> firstChild;
+    std::vector<size_t> levelEnds;
+    std::vector<RoadSegment*> items;
+    std::shared_ptr<const void> backingStorage;
+
+    size_t levelEndFor(size_t position) const;
+
+    static Box boxOf(const RoadSegment* segment);
+    static double distanceToBox(double lat, double lon, double metersPerDegreeLon, const Box& box);
+    static double segmentDistance(double lat, double lon, double metersPerDegreeLon, const RoadSegment* segment);
+};
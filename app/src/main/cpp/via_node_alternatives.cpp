@@ -0,0 +1,336 @@
+/*
+ * File: via_node_alternatives.cpp
+ * Description: Implementation of the ViaNodeAlternatives class, responsible for shortest-path trees, plateau detection and via-route selection.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#include "via_node_alternatives.h"
+#include "road_graph.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#define LOG_TAG "ViaNodeAlternatives"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+
+void ViaNodeAlternatives::growForward(const CompactGraph& graph, uint32_t start, uint32_t end) {
+    growTree(graph, FORWARD, start, end);
+}
+
+void ViaNodeAlternatives::growBackward(const CompactGraph& graph, uint32_t start, uint32_t end) {
+    growTree(graph, BACKWARD, end, start);
+}
+
+void ViaNodeAlternatives::growTree(const CompactGraph& graph, int side, uint32_t root, uint32_t target) {
+    SearchWorkspace& tree = trees[side];
+    std::vector<uint32_t>& order = settled[side];
+    tree.reset(graph.getNodesCount());
+    order.clear();
+
+    // The reverse adjacency has no edges out of interior chain nodes, so the backward tree cannot
+    // settle a start inside a chain. It aims for every node the start's chain leads to instead.
+    std::unordered_map<uint32_t, double> exits;
+    if (side == BACKWARD) {
+        walkFromStart(graph, target);
+        for (const WalkStep& step : startWalk) {
+            exits.emplace(step.node, step.distance);
+        }
+    } else {
+        exits.emplace(target, 0.0);
+    }
+
+    IndexedHeap& queue = tree.queue();
+    tree.setDistance(root, 0.0, {CompactGraph::INVALID_NODE, CompactGraph::INVALID_EDGE});
+    queue.push(root, 0.0);
+
+    // Once the other endpoint is reached, only nodes that can lie on a short enough detour matter.
+    double shortest = std::numeric_limits<double>::infinity();
+    while (!queue.empty()) {
+        IndexedHeap::Entry current = queue.pop();
+        if (current.key > (1.0 + MAX_STRETCH) * shortest) {
+            break;
+        }
+        tree.settle(current.node);
+        order.push_back(current.node);
+
+        auto exit = exits.find(current.node);
+        if (exit != exits.end()) {
+            shortest = std::min(shortest, current.key + exit->second);
+        }
+
+        auto relax = [&](uint32_t next, const CompactGraph::Edge& edge, uint32_t edgeId) {
+            double distance = current.key + edge.length;
+            if (!tree.isSettled(next) && distance < tree.distance(next)) {
+                tree.setDistance(next, distance, {current.node, edgeId});
+                queue.push(next, distance);
+            }
+        };
+
+        if (side == FORWARD) {
+            graph.forEachEdge(current.node, [&](const CompactGraph::Edge& edge, uint32_t edgeId) {
+                relax(edge.target, edge, edgeId);
+            });
+        } else {
+            graph.forEachReverseEdge(current.node, [&](uint32_t source, const CompactGraph::Edge& edge, uint32_t edgeId) {
+                relax(source, edge, edgeId);
+            });
+        }
+    }
+
+    if (side == BACKWARD) {
+        extendAlongStartWalk();
+    }
+}
+
+void ViaNodeAlternatives::walkFromStart(const CompactGraph& graph, uint32_t start) {
+    startWalk.clear();
+    startWalk.push_back({start, 0, CompactGraph::INVALID_EDGE, 0.0});
+
+    // Chains are paths, so each node is reached once; the check only guards closed loops.
+    for (size_t i = 0; i < startWalk.size(); i++) {
+        WalkStep current = startWalk[i];
+        if (i > 0 && !graph.isChainInterior(current.node)) {
+            continue;
+        }
+        graph.forEachEdge(current.node, [&](const CompactGraph::Edge& edge, uint32_t edgeId) {
+            for (const WalkStep& known : startWalk) {
+                if (known.node == edge.target) {
+                    return;
+                }
+            }
+            startWalk.push_back({edge.target, static_cast<uint32_t>(i), edgeId, current.distance + edge.length});
+        });
+    }
+}
+
+void ViaNodeAlternatives::extendAlongStartWalk() {
+    SearchWorkspace& tree = trees[BACKWARD];
+
+    // Children follow their parents in the walk, so a reverse pass finalises each node
+    // before it labels its parent.
+    for (size_t i = startWalk.size(); i-- > 0;) {
+        const WalkStep& step = startWalk[i];
+        if (!tree.isReached(step.node)) {
+            continue;
+        }
+        tree.settle(step.node);
+        if (i == 0) {
+            continue;
+        }
+
+        const WalkStep& parent = startWalk[step.parent];
+        double distance = tree.distance(step.node) + (step.distance - parent.distance);
+        if (!tree.isSettled(parent.node) && distance < tree.distance(parent.node)) {
+            tree.setDistance(parent.node, distance, {step.node, step.edge});
+        }
+    }
+}
+
+std::vector<std::vector<uint32_t>> ViaNodeAlternatives::select(const CompactGraph& graph,
+                                                               uint32_t start, uint32_t end,
+                                                               const std::vector<uint32_t>& primary,
+                                                               size_t count) {
+    std::vector<std::vector<uint32_t>> alternatives;
+    const SearchWorkspace& forward = trees[FORWARD];
+    const SearchWorkspace& backward = trees[BACKWARD];
+    if (count == 0 || !forward.isSettled(end) || !backward.isSettled(start)) {
+        return alternatives;
+    }
+
+    double shortest = forward.distance(end);
+    double limit = (1.0 + MAX_STRETCH) * shortest;
+
+    // Candidates are edges u -> w joining the two trees. An edge, rather than a node, lets a
+    // detour along a contracted chain count even though the chain has no junction inside.
+    std::vector<ViaEdge> candidates;
+    for (uint32_t node : settled[FORWARD]) {
+        graph.forEachEdge(node, [&](const CompactGraph::Edge& edge, uint32_t edgeId) {
+            if (!backward.isSettled(edge.target)) {
+                return;
+            }
+            double length = forward.distance(node) + edge.length + backward.distance(edge.target);
+            if (length <= limit) {
+                candidates.push_back({length, node, edge.target, edgeId, edge.length});
+            }
+        });
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const ViaEdge& a, const ViaEdge& b) {
+        return a.length < b.length;
+    });
+
+    std::unordered_set<uint64_t> chosenEdges;
+    auto edgeKey = [](uint32_t from, uint32_t to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    };
+    auto choose = [&](const std::vector<uint32_t>& path) {
+        for (size_t i = 1; i < path.size(); i++) {
+            chosenEdges.insert(edgeKey(path[i - 1], path[i]));
+        }
+    };
+    choose(primary);
+
+    visitedPlateau.assign(graph.getNodesCount(), false);
+    size_t plateaus = 0;
+    std::vector<uint32_t> path;
+
+    for (const ViaEdge& candidate : candidates) {
+        if (alternatives.size() >= count) {
+            break;
+        }
+        // Every edge of a plateau yields the same via route, so each plateau is tried once.
+        if (inBothTrees(candidate) && visitedPlateau[candidate.from]) {
+            continue;
+        }
+        plateaus++;
+        if (plateauLength(graph, candidate, start, end) < MIN_PLATEAU * shortest) {
+            continue;
+        }
+        if (!buildViaPath(graph, start, candidate, end, path)) {
+            continue;
+        }
+
+        double shared = 0.0;
+        for (size_t i = 1; i < path.size(); i++) {
+            if (chosenEdges.count(edgeKey(path[i - 1], path[i]))) {
+                shared += RoadGraph::haversineDistance(graph.latitude(path[i - 1]), graph.longitude(path[i - 1]),
+                                                       graph.latitude(path[i]), graph.longitude(path[i]));
+            }
+        }
+        if (shared > MAX_SHARING * shortest) {
+            continue;
+        }
+
+        choose(path);
+        alternatives.push_back(path);
+    }
+
+    LOGD("Chose %zu alternatives from %zu via edges on %zu plateaus",
+         alternatives.size(), candidates.size(), plateaus);
+    return alternatives;
+}
+
+bool ViaNodeAlternatives::inForwardTree(const ViaEdge& via) const {
+    const SearchWorkspace::Step& step = trees[FORWARD].step(via.to);
+    return step.previous == via.from && step.edge == via.edge;
+}
+
+bool ViaNodeAlternatives::inBothTrees(const ViaEdge& via) const {
+    const SearchWorkspace::Step& step = trees[BACKWARD].step(via.from);
+    return inForwardTree(via) && step.previous == via.to && step.edge == via.edge;
+}
+
+double ViaNodeAlternatives::plateauLength(const CompactGraph& graph, const ViaEdge& via,
+                                          uint32_t start, uint32_t end) {
+    const SearchWorkspace& forward = trees[FORWARD];
+    const SearchWorkspace& backward = trees[BACKWARD];
+    const SearchWorkspace::Step& out = backward.step(via.from);
+    bool forwardAgrees = inForwardTree(via);
+    bool backwardAgrees = out.previous == via.to && out.edge == via.edge;
+
+    // Inside a chain, the forward tree enters from `from` up to where the way round through `to`
+    // gets shorter, and the backward tree leaves through `to` from where the way back through
+    // `from` gets longer. That only happens on two-way chains; the overlap is plateau.
+    double inner = 0.0;
+    if (forwardAgrees && backwardAgrees) {
+        inner = via.edgeLength;
+    } else {
+        bool hasInterior = false;
+        graph.forEachViaNode(via.edge, [&](uint32_t) { hasInterior = true; });
+        if (hasInterior) {
+            bool twoWay = false;
+            graph.forEachEdge(via.to, [&](const CompactGraph::Edge& edge, uint32_t) {
+                twoWay = twoWay || (edge.target == via.from && std::fabs(edge.length - via.edgeLength) < 1e-3);
+            });
+
+            double forwardReach = via.edgeLength;
+            double backwardReach = 0.0;
+            if (twoWay && !forwardAgrees) {
+                forwardReach = 0.5 * (forward.distance(via.to) + via.edgeLength - forward.distance(via.from));
+            }
+            if (twoWay && !backwardAgrees) {
+                backwardReach = 0.5 * (backward.distance(via.to) + via.edgeLength - backward.distance(via.from));
+            }
+            inner = std::max(0.0, std::min(forwardReach, static_cast<double>(via.edgeLength)) -
+                                  std::max(backwardReach, 0.0));
+        }
+    }
+
+    // Tree edges both searches agree on extend the plateau past the ends of the via edge.
+    double outer = 0.0;
+    if (backwardAgrees) {
+        visitedPlateau[via.from] = true;
+        uint32_t first = via.from;
+        while (first != start) {
+            const SearchWorkspace::Step& into = forward.step(first);
+            if (!backward.isSettled(into.previous)) {
+                break;
+            }
+            const SearchWorkspace::Step& next = backward.step(into.previous);
+            if (next.previous != first || next.edge != into.edge) {
+                break;
+            }
+            first = into.previous;
+            visitedPlateau[first] = true;
+        }
+        outer += forward.distance(via.from) - forward.distance(first);
+    }
+    if (forwardAgrees) {
+        visitedPlateau[via.to] = true;
+        uint32_t last = via.to;
+        while (last != end) {
+            const SearchWorkspace::Step& next = backward.step(last);
+            if (!forward.isSettled(next.previous)) {
+                break;
+            }
+            const SearchWorkspace::Step& into = forward.step(next.previous);
+            if (into.previous != last || into.edge != next.edge) {
+                break;
+            }
+            last = next.previous;
+            visitedPlateau[last] = true;
+        }
+        outer += backward.distance(via.to) - backward.distance(last);
+    }
+
+    return inner + outer;
+}
+
+bool ViaNodeAlternatives::buildViaPath(const CompactGraph& graph, uint32_t start, const ViaEdge& via,
+                                       uint32_t end, std::vector<uint32_t>& path) const {
+    const SearchWorkspace& forward = trees[FORWARD];
+    const SearchWorkspace& backward = trees[BACKWARD];
+
+    std::vector<uint32_t> heads;
+    for (uint32_t node = via.from; node != start; node = forward.step(node).previous) {
+        heads.push_back(node);
+    }
+
+    path.clear();
+    path.push_back(start);
+    auto append = [&](uint32_t node) { path.push_back(node); };
+    for (auto it = heads.rbegin(); it != heads.rend(); ++it) {
+        graph.forEachViaNode(forward.step(*it).edge, append);
+        path.push_back(*it);
+    }
+    graph.forEachViaNode(via.edge, append);
+    path.push_back(via.to);
+    for (uint32_t node = via.to; node != end;) {
+        const SearchWorkspace::Step& step = backward.step(node);
+        graph.forEachViaNode(step.edge, append);
+        path.push_back(step.previous);
+        node = step.previous;
+    }
+
+    // Both halves are shortest paths, but together they may double back on themselves.
+    std::unordered_set<uint32_t> seen;
+    for (uint32_t node : path) {
+        if (!seen.insert(node).second) {
+            return false;
+        }
+    }
+    return true;
+}
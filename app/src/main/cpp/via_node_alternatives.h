@@ -0,0 +1,80 @@
+/*
+ * File: via_node_alternatives.h
+ * Description: Header file for the ViaNodeAlternatives class, alternative routes chosen from forward and backward shortest-path trees.
+ * Author: Giuseppe Franco
+ * Created: October 2026
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "compact_graph.h"
+#include "search_workspace.h"
+
+// An alternative is the shortest route through a via edge u -> w: start -> u in the forward tree,
+// the edge, then w -> end in the backward tree. Via edges are grouped into plateaus, runs of edges
+// both trees share, and an alternative is admissible when it is at most MAX_STRETCH longer than
+// the shortest route, shares at most MAX_SHARING of it with the routes already chosen and its
+// plateau covers MIN_PLATEAU of it, which keeps the detour locally optimal.
+class ViaNodeAlternatives {
+public:
+    static constexpr double MAX_STRETCH = 0.25;
+    static constexpr double MAX_SHARING = 0.8;
+    static constexpr double MIN_PLATEAU = 0.2;
+
+    // The trees grow on pool workers but are owned by the thread that asked for the route.
+    static ViaNodeAlternatives& forThread() {
+        thread_local ViaNodeAlternatives alternatives;
+        return alternatives;
+    }
+
+    // The two trees only read the graph and can be grown concurrently.
+    void growForward(const CompactGraph& graph, uint32_t start, uint32_t end);
+    void growBackward(const CompactGraph& graph, uint32_t start, uint32_t end);
+
+    // Returns up to `count` alternative node paths, best first. `primary` is the shortest route,
+    // expanded to consecutive nodes.
+    std::vector<std::vector<uint32_t>> select(const CompactGraph& graph, uint32_t start, uint32_t end,
+                                              const std::vector<uint32_t>& primary, size_t count);
+
+private:
+    static constexpr int FORWARD = 0;
+    static constexpr int BACKWARD = 1;
+
+    // An edge from a node of the forward tree to a node of the backward tree.
+    struct ViaEdge {
+        double length;
+        uint32_t from;
+        uint32_t to;
+        uint32_t edge;
+        float edgeLength;
+    };
+
+    // A node reached from the start without passing a junction, with the walk edge into it.
+    struct WalkStep {
+        uint32_t node;
+        uint32_t parent;
+        uint32_t edge;
+        double distance;
+    };
+
+    SearchWorkspace trees[2];
+    std::vector<uint32_t> settled[2];
+    std::vector<WalkStep> startWalk;
+    std::vector<bool> visitedPlateau;
+
+    void growTree(const CompactGraph& graph, int side, uint32_t root, uint32_t target);
+
+    void walkFromStart(const CompactGraph& graph, uint32_t start);
+    void extendAlongStartWalk();
+
+    bool inForwardTree(const ViaEdge& via) const;
+    bool inBothTrees(const ViaEdge& via) const;
+
+    double plateauLength(const CompactGraph& graph, const ViaEdge& via, uint32_t start, uint32_t end);
+
+    bool buildViaPath(const CompactGraph& graph, uint32_t start, const ViaEdge& via, uint32_t end,
+                      std::vector<uint32_t>& path) const;
+};